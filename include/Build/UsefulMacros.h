@@ -98,6 +98,14 @@
 #define ContainerOf(memberptr, Type, member)    \
     reinterpret_cast<Type*>(reinterpret_cast<char*>(memberptr) - OffsetOf(Type, member))
 
+//
+// size of a cache line, used to pad data that is written by different
+// threads so that it doesn't share a line (false sharing).
+//
+#ifndef CACHE_LINE_SIZE
+#   define CACHE_LINE_SIZE 64
+#endif
+
 #define min_t(Type, x, y) ({            \
     Type __min1 = (x);                    \
     Type __min2 = (y);                    \
@@ -0,0 +1,102 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_ABSTRACT_QUEUE_H
+#define CONCURRENCY_ABSTRACT_QUEUE_H
+
+#include <Config.h>
+#include <vector>
+#include <Util/SharedPtr.h>
+#include <Util/Time.h>
+
+THREADING_BEGIN
+
+//
+// Run-time interface over the thread-safe queues (ThreadSafeQueue,
+// RingQueue), so a user such as ThreadPool can pick its queue from
+// configuration. Wrap a queue with AbstractQueueI<Q> to get one.
+//
+template <typename T>
+class AbstractQueue
+{
+public:
+    typedef T value_type;
+
+    virtual ~AbstractQueue()
+    {}
+
+    virtual SharedPtr<T> TryPop() = 0;
+    virtual SharedPtr<T> Pop() = 0;
+    virtual SharedPtr<T> TimedPop(const Time& timeout) = 0;
+    virtual void Push(const SharedPtr<T>& new_value) = 0;
+    virtual bool TryPush(const SharedPtr<T>& new_value) = 0;     // False if the queue is full.
+    virtual void PushBatch(const std::vector<SharedPtr<T> >& values) = 0;
+    virtual size_t PopBatch(std::vector<SharedPtr<T> >& values, size_t max_count, const Time& timeout) = 0;
+    virtual bool Empty() = 0;
+};
+
+template <typename Q>
+class AbstractQueueI : public AbstractQueue<typename Q::value_type>, public Q
+{
+public:
+    typedef typename Q::value_type value_type;
+
+    AbstractQueueI()
+    {}
+
+    template <typename A>
+    explicit AbstractQueueI(const A& arg) : Q(arg)
+    {}
+
+    virtual SharedPtr<value_type> TryPop()
+    {
+        return Q::TryPop();
+    }
+
+    virtual SharedPtr<value_type> Pop()
+    {
+        return Q::Pop();
+    }
+
+    virtual SharedPtr<value_type> TimedPop(const Time& timeout)
+    {
+        return Q::TimedPop(timeout);
+    }
+
+    virtual void Push(const SharedPtr<value_type>& new_value)
+    {
+        Q::Push(new_value);
+    }
+
+    virtual bool TryPush(const SharedPtr<value_type>& new_value)
+    {
+        return Q::TryPush(new_value);
+    }
+
+    virtual void PushBatch(const std::vector<SharedPtr<value_type> >& values)
+    {
+        Q::PushBatch(values.begin(), values.end());
+    }
+
+    virtual size_t PopBatch(std::vector<SharedPtr<value_type> >& values, size_t max_count, const Time& timeout)
+    {
+        return Q::PopBatch(values, max_count, timeout);
+    }
+
+    virtual bool Empty()
+    {
+        return Q::Empty();
+    }
+
+    virtual ~AbstractQueueI()
+    {}
+};
+
+THREADING_END
+
+#endif
@@ -13,15 +13,22 @@
 // This file must include *all* other headers of Concurrency.
 //
 #include <Concurrency/AbstractMutex.h>
+#include <Concurrency/AbstractQueue.h>
 #include <Config.h>
 #include <Concurrency/Cond.h>
 #include <Concurrency/CountdownLatch.h>
+#include <Concurrency/CpuSet.h>
+#include <Concurrency/EventCount.h>
+#include <Concurrency/Future.h>
+#include <Concurrency/LaneQueue.h>
 #include <Concurrency/Lock.h>
+#include <Concurrency/MemoryReclamation.h>
 #include <Concurrency/Monitor.h>
 #include <Concurrency/Mutex.h>
 #include <Concurrency/MutexPtrLock.h>
 #include <Concurrency/RWRecMutex.h>
 #include <Concurrency/RecMutex.h>
+#include <Concurrency/RingQueue.h>
 #include <Concurrency/StaticMutex.h>
 #include <Concurrency/SpinMutex.h>
 #include <Concurrency/Thread.h>
@@ -30,5 +37,6 @@
 #include <Concurrency/ThreadPool.h>
 #include <Concurrency/ThreadLocal.h>
 #include <Concurrency/Timer.h>
+#include <Concurrency/WorkStealingQueue.h>
 
 #endif
\ No newline at end of file
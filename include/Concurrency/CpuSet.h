@@ -0,0 +1,70 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_CPU_SET_H
+#define CONCURRENCY_CPU_SET_H
+
+#include <Config.h>
+#include <string>
+#include <vector>
+
+#if defined(__linux)
+#   include <sched.h>
+#endif
+
+THREADING_BEGIN
+
+//
+// Set of logical CPUs a thread may run on; see Thread::Start and
+// ThreadControl::SetAffinity. An empty set means "no affinity".
+//
+class THREADING_API CpuSet
+{
+public:
+    CpuSet();
+
+    //
+    // Parses a CPU list such as "0-7,16,18-19". Throws
+    // IllegalArgumentException for a malformed list.
+    //
+    explicit CpuSet(const std::string& cpulist);
+
+    void Set(size_t cpu);
+
+    void Clear(size_t cpu);
+
+    bool IsSet(size_t cpu) const;
+
+    bool Empty() const;
+
+    size_t Count() const;
+
+    // The CPUs of the set in increasing order.
+    std::vector<size_t> Cpus() const;
+
+    std::string ToString() const;
+
+    bool operator ==(const CpuSet& rhs) const;
+
+    // CPUs the calling process may run on.
+    static CpuSet Available();
+
+    // NUMA node of cpu, 0 if unknown or the machine isn't NUMA.
+    static int NumaNode(size_t cpu);
+
+#if defined(__linux)
+    void Fill(cpu_set_t& set) const;
+#endif
+
+private:
+    std::vector<bool> m_cpus;
+};
+
+THREADING_END
+
+#endif
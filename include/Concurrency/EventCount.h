@@ -0,0 +1,75 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_EVENT_COUNT_H
+#define CONCURRENCY_EVENT_COUNT_H
+
+#include <Config.h>
+#include <Concurrency/Mutex.h>
+#include <Concurrency/Cond.h>
+#include <Util/Time.h>
+#include <Util/Atomic.h>
+
+THREADING_BEGIN
+
+//
+// EventCount lets lock-free data structures block a thread on a condition
+// without taking a lock on the fast path. A waiter announces itself with
+// PrepareWait(), re-checks its condition and then either CancelWait()s or
+// Wait()s with the returned key. A notifier that finds no announced waiter
+// returns after a single atomic load, so producers and consumers only touch
+// the mutex and condition variable when somebody really sleeps:
+//
+//     while (!queue.TryPop(value))
+//     {
+//         EventCount::Key key = event.PrepareWait();
+//         if (queue.TryPop(value))
+//         {
+//             event.CancelWait();
+//             break;
+//         }
+//         event.Wait(key);
+//     }
+//
+class THREADING_API EventCount : public noncopyable
+{
+public:
+    typedef unsigned int Key;
+
+    EventCount(void);
+    ~EventCount(void);
+
+    Key PrepareWait();
+
+    void CancelWait();
+
+    void Wait(Key key);
+
+    // Returns false if the timeout expired before a notification.
+    bool TimedWait(Key key, const Time& timeout);
+
+    // Wakes at least one waiter, if there is any.
+    void Notify();
+
+    void NotifyAll();
+
+    bool HasWaiters() const;
+
+private:
+    void doNotify(bool broadcast);
+
+    Threading::AtomicInt m_waiters;
+    volatile Key m_epoch;
+
+    Threading::Mutex m_mutex;
+    Threading::Cond m_cond;
+};
+
+THREADING_END
+
+#endif
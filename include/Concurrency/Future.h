@@ -0,0 +1,580 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_FUTURE_H
+#define CONCURRENCY_FUTURE_H
+
+#include <Config.h>
+#include <vector>
+#include <utility>
+#include <Concurrency/ThreadPool.h>
+#include <Concurrency/ThreadException.h>
+#include <Concurrency/Monitor.h>
+#include <Util/Atomic.h>
+#include <Util/UniquePtr.h>
+#include <Util/Exception.h>
+
+THREADING_BEGIN
+
+template<typename T> class Future;
+template<typename T> class Promise;
+
+//
+// Result type of a callable passed to ThreadPool::Submit or Future::Then:
+// function objects declare a result_type (as std::unary_function does),
+// plain functions are recognised by their signature.
+//
+template<typename F>
+struct CallableResult
+{
+    typedef typename F::result_type type;
+};
+
+template<typename R>
+struct CallableResult<R (*)()>
+{
+    typedef R type;
+};
+
+template<typename R, typename A>
+struct CallableResult<R (*)(A)>
+{
+    typedef R type;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// class FutureStateBase
+//
+// The part of the state shared by a Promise and its Futures that doesn't
+// depend on the value type: the ready flag, the exception and the
+// continuations to run once the result is set. Waiting threads are only
+// signaled if there are any, so a result nobody blocks on costs no
+// condition variable traffic.
+//
+class THREADING_API FutureStateBase : public Threading::Shared, public Threading::Monitor<Threading::Mutex>
+{
+public:
+    FutureStateBase();
+    virtual ~FutureStateBase();
+
+    bool IsReady() const;
+
+    bool HasException() const;
+
+    void WaitReady() const;
+
+    bool TimedWaitReady(const Time& timeout) const;
+
+    void SetException(const Exception& ex);
+
+    // Stores the exception being handled; must be called from a catch block.
+    void SetCurrentException();
+
+    //
+    // Runs task once the result is set: on pool if there is one, otherwise
+    // inline on the thread that sets the result (or on the caller if the
+    // result is already there).
+    //
+    void AddContinuation(const TaskPtr& task, const ThreadPoolPtr& pool);
+
+    void PromiseAttached();
+
+    void PromiseDetached();
+
+protected:
+    typedef std::vector<std::pair<TaskPtr, ThreadPoolPtr> > Continuations;
+
+    // Both must be called with the state locked.
+    void checkNotReady() const;
+    void setReady(Continuations& continuations);
+
+    static void runContinuations(const Continuations& continuations);
+
+    void waitReady() const;
+
+    bool m_ready;
+    UniquePtr<Exception> m_exception;
+
+private:
+    mutable int m_waiters;
+    Continuations m_continuations;
+    AtomicInt m_promises;       // Number of Promise objects that can still set the result.
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// class FutureState
+template<typename T>
+class FutureState : public FutureStateBase
+{
+public:
+    void SetValue(const T& value)
+    {
+        Continuations continuations;
+        {
+            Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+            checkNotReady();
+            m_value.Reset(new T(value));
+            setReady(continuations);
+        }
+        runContinuations(continuations);
+    }
+
+    T Get() const
+    {
+        waitReady();
+        return *m_value;
+    }
+
+private:
+    UniquePtr<T> m_value;
+};
+
+template<>
+class FutureState<void> : public FutureStateBase
+{
+public:
+    void SetValue()
+    {
+        Continuations continuations;
+        {
+            Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+            checkNotReady();
+            setReady(continuations);
+        }
+        runContinuations(continuations);
+    }
+
+    void Get() const
+    {
+        waitReady();
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// class Future
+//
+// Read side of an asynchronous result. Futures are cheap to copy, all the
+// copies share the same state.
+//
+// Then() attaches a continuation, a callable taking a const Future<T>&,
+// and returns the future of its result. Without a pool the continuation
+// runs inline on the thread that completes this future, which is right for
+// cheap work such as transforming the value or completing another promise;
+// anything heavier should be given a pool to be scheduled on:
+//
+//     Future<int> size = pool->Submit(ReadRequest(id));
+//     Future<bool> done = size.Then(pool, StoreReply(id));
+//
+template<typename T>
+class Future
+{
+public:
+    typedef T value_type;
+
+    Future()
+    {}
+
+    explicit Future(const SharedPtr<FutureState<T> >& state) : m_state(state)
+    {}
+
+    bool Valid() const
+    {
+        return m_state ? true : false;
+    }
+
+    bool IsReady() const
+    {
+        checkValid();
+        return m_state->IsReady();
+    }
+
+    bool HasException() const
+    {
+        checkValid();
+        return m_state->HasException();
+    }
+
+    void Wait() const
+    {
+        checkValid();
+        m_state->WaitReady();
+    }
+
+    bool TimedWait(const Time& timeout) const
+    {
+        checkValid();
+        return m_state->TimedWaitReady(timeout);
+    }
+
+    // Waits for the result; throws the exception the producer failed with.
+    T Get() const
+    {
+        checkValid();
+        return m_state->Get();
+    }
+
+    // Runs task once the result is set, on pool or inline; see Then().
+    void OnReady(const TaskPtr& task, const ThreadPoolPtr& pool = ThreadPoolPtr()) const
+    {
+        checkValid();
+        m_state->AddContinuation(task, pool);
+    }
+
+    template<typename F>
+    Future<typename CallableResult<F>::type> Then(F fun) const
+    {
+        return then(fun, ThreadPoolPtr());
+    }
+
+    template<typename F>
+    Future<typename CallableResult<F>::type> Then(const ThreadPoolPtr& pool, F fun) const
+    {
+        return then(fun, pool);
+    }
+
+private:
+    template<typename F>
+    Future<typename CallableResult<F>::type> then(F fun, const ThreadPoolPtr& pool) const;
+
+    void checkValid() const
+    {
+        if (!m_state)
+        {
+            throw FutureException(__FILE__, __LINE__, "future has no state");
+        }
+    }
+
+    SharedPtr<FutureState<T> > m_state;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// class Promise
+//
+// Write side of an asynchronous result. The result can be set once; if
+// the last copy of a promise goes away without setting it, its futures
+// fail with a FutureException ("broken promise").
+//
+template<typename T>
+class PromiseBase
+{
+public:
+    PromiseBase() : m_state(new FutureState<T>())
+    {
+        m_state->PromiseAttached();
+    }
+
+    PromiseBase(const PromiseBase& rhs) : m_state(rhs.m_state)
+    {
+        m_state->PromiseAttached();
+    }
+
+    PromiseBase& operator =(const PromiseBase& rhs)
+    {
+        if (m_state.Get() != rhs.m_state.Get())
+        {
+            rhs.m_state->PromiseAttached();
+            m_state->PromiseDetached();
+            m_state = rhs.m_state;
+        }
+        return *this;
+    }
+
+    ~PromiseBase()
+    {
+        m_state->PromiseDetached();
+    }
+
+    Future<T> GetFuture() const
+    {
+        return Future<T>(m_state);
+    }
+
+    void SetException(const Exception& ex)
+    {
+        m_state->SetException(ex);
+    }
+
+    void SetCurrentException()
+    {
+        m_state->SetCurrentException();
+    }
+
+protected:
+    SharedPtr<FutureState<T> > m_state;
+};
+
+template<typename T>
+class Promise : public PromiseBase<T>
+{
+public:
+    void SetValue(const T& value)
+    {
+        this->m_state->SetValue(value);
+    }
+};
+
+template<>
+class Promise<void> : public PromiseBase<void>
+{
+public:
+    void SetValue()
+    {
+        m_state->SetValue();
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// struct PromiseSetter
+//
+// Calls a callable and stores its result, or the exception it throws, in
+// a promise.
+//
+template<typename R>
+struct PromiseSetter
+{
+    template<typename F>
+    static void Call(Promise<R>& promise, F& fun)
+    {
+        try
+        {
+            promise.SetValue(fun());
+        }
+        catch (...)
+        {
+            promise.SetCurrentException();
+        }
+    }
+
+    template<typename F, typename A>
+    static void Call(Promise<R>& promise, F& fun, const A& arg)
+    {
+        try
+        {
+            promise.SetValue(fun(arg));
+        }
+        catch (...)
+        {
+            promise.SetCurrentException();
+        }
+    }
+};
+
+template<>
+struct PromiseSetter<void>
+{
+    template<typename F>
+    static void Call(Promise<void>& promise, F& fun)
+    {
+        try
+        {
+            fun();
+            promise.SetValue();
+        }
+        catch (...)
+        {
+            promise.SetCurrentException();
+        }
+    }
+
+    template<typename F, typename A>
+    static void Call(Promise<void>& promise, F& fun, const A& arg)
+    {
+        try
+        {
+            fun(arg);
+            promise.SetValue();
+        }
+        catch (...)
+        {
+            promise.SetCurrentException();
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// class FutureTask
+// The task ThreadPool::Submit queues: runs the callable into a promise.
+template<typename R, typename F>
+class FutureTask : public TaskBase
+{
+public:
+    FutureTask(F fun, const Promise<R>& promise) : TaskBase("")
+        , m_fun(fun)
+        , m_promise(promise)
+    {
+    }
+
+    virtual void Run()
+    {
+        PromiseSetter<R>::Call(m_promise, m_fun);
+    }
+
+private:
+    F m_fun;
+    Promise<R> m_promise;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// class ContinuationTask
+template<typename T, typename R, typename F>
+class ContinuationTask : public TaskBase
+{
+public:
+    ContinuationTask(const Future<T>& future, F fun, const Promise<R>& promise) : TaskBase("")
+        , m_future(future)
+        , m_fun(fun)
+        , m_promise(promise)
+    {
+    }
+
+    virtual void Run()
+    {
+        PromiseSetter<R>::Call(m_promise, m_fun, m_future);
+    }
+
+private:
+    Future<T> m_future;
+    F m_fun;
+    Promise<R> m_promise;
+};
+
+template<typename T>
+template<typename F>
+Future<typename CallableResult<F>::type> Future<T>::then(F fun, const ThreadPoolPtr& pool) const
+{
+    typedef typename CallableResult<F>::type R;
+
+    checkValid();
+    Promise<R> promise;
+    Future<R> result = promise.GetFuture();
+    OnReady(new ContinuationTask<T, R, F>(*this, fun, promise), pool);
+    return result;
+}
+
+template<typename F>
+Future<typename CallableResult<F>::type> ThreadPool::Submit(F fun)
+{
+    typedef typename CallableResult<F>::type R;
+
+    Promise<R> promise;
+    Future<R> result = promise.GetFuture();
+    SubmitTask(new FutureTask<R, F>(fun, promise));
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// WhenAll / WhenAny
+//
+// Combine several futures without blocking a thread on them: every input
+// gets an inline continuation that counts down (WhenAll) or races to set
+// the result (WhenAny). WhenAll hands back the input futures, all ready,
+// so the caller can Get() each value or exception; WhenAny gives the index
+// of the first future that became ready.
+//
+template<typename T>
+class WhenAllState : public Threading::Shared
+{
+public:
+    WhenAllState(const std::vector<Future<T> >& futures) :
+        m_futures(futures),
+        m_remaining(static_cast<int>(futures.size()))
+    {
+    }
+
+    void Done(size_t)
+    {
+        if (0 == --m_remaining)
+        {
+            m_promise.SetValue(m_futures);
+        }
+    }
+
+    std::vector<Future<T> > m_futures;
+    AtomicInt m_remaining;
+    Promise<std::vector<Future<T> > > m_promise;
+};
+
+template<typename T>
+class WhenAnyState : public Threading::Shared
+{
+public:
+    WhenAnyState() : m_fired(0)
+    {
+    }
+
+    void Done(size_t index)
+    {
+        if (0 == m_fired++)
+        {
+            m_promise.SetValue(index);
+        }
+    }
+
+    AtomicInt m_fired;
+    Promise<size_t> m_promise;
+};
+
+template<typename S>
+class WhenTask : public TaskBase
+{
+public:
+    WhenTask(const SharedPtr<S>& state, size_t index) : TaskBase("")
+        , m_state(state)
+        , m_index(index)
+    {
+    }
+
+    virtual void Run()
+    {
+        m_state->Done(m_index);
+    }
+
+private:
+    SharedPtr<S> m_state;
+    const size_t m_index;
+};
+
+template<typename T>
+Future<std::vector<Future<T> > > WhenAll(const std::vector<Future<T> >& futures)
+{
+    SharedPtr<WhenAllState<T> > state = new WhenAllState<T>(futures);
+    Future<std::vector<Future<T> > > result = state->m_promise.GetFuture();
+    if (futures.empty())
+    {
+        state->m_promise.SetValue(futures);
+        return result;
+    }
+
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        futures[i].OnReady(new WhenTask<WhenAllState<T> >(state, i));
+    }
+    return result;
+}
+
+template<typename T>
+Future<size_t> WhenAny(const std::vector<Future<T> >& futures)
+{
+    SharedPtr<WhenAnyState<T> > state = new WhenAnyState<T>();
+    Future<size_t> result = state->m_promise.GetFuture();
+    if (futures.empty())
+    {
+        state->m_promise.SetException(FutureException(__FILE__, __LINE__, "WhenAny of no futures"));
+        return result;
+    }
+
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        futures[i].OnReady(new WhenTask<WhenAnyState<T> >(state, i));
+    }
+    return result;
+}
+
+THREADING_END
+
+#endif
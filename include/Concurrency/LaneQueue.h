@@ -0,0 +1,267 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_LANE_QUEUE_H
+#define CONCURRENCY_LANE_QUEUE_H
+
+#include <Config.h>
+#include <vector>
+#include <Concurrency/AbstractQueue.h>
+#include <Concurrency/EventCount.h>
+#include <Util/Atomic.h>
+#include <Util/Exception.h>
+
+THREADING_BEGIN
+
+//
+// Queue made of priority lanes, lane 0 being the most urgent: a pop takes
+// from the first non-empty lane, so urgent work overtakes whatever is
+// queued in the lanes below it.
+//
+// To keep a flood of urgent work from starving the lower lanes, every
+// aging-th pop scans the lanes the other way round and is served from the
+// lowest non-empty lane (aging 0 disables this).
+//
+// The lanes are any AbstractQueue's and are owned by the LaneQueue. Push()
+// without a lane uses the default lane.
+//
+template<typename T>
+class LaneQueue : public AbstractQueue<T>, public noncopyable
+{
+public:
+    typedef T value_type;
+
+    LaneQueue(const std::vector<AbstractQueue<T>*>& lanes, size_t default_lane, size_t aging) :
+        m_lanes(lanes),
+        m_depths(lanes.size()),
+        m_defaultlane(default_lane),
+        m_aging(static_cast<int>(aging)),
+        m_pops(0)
+    {
+        if (m_lanes.empty() || m_defaultlane >= m_lanes.size())
+        {
+            throw IllegalArgumentException(__FILE__, __LINE__, "LaneQueue needs a lane and a valid default lane");
+        }
+
+        for (size_t i = 0; i < m_depths.size(); ++i)
+        {
+            m_depths[i] = new AtomicInt(0);
+        }
+    }
+
+    virtual ~LaneQueue()
+    {
+        for (size_t i = 0; i < m_lanes.size(); ++i)
+        {
+            delete m_lanes[i];
+            delete m_depths[i];
+        }
+    }
+
+    size_t Lanes() const
+    {
+        return m_lanes.size();
+    }
+
+    // Number of elements queued in lane.
+    size_t Depth(size_t lane) const
+    {
+        int depth = *m_depths[lane];
+        return depth > 0 ? static_cast<size_t>(depth) : 0;
+    }
+
+    void Push(const SharedPtr<T>& new_value, size_t lane)
+    {
+        lane = clampLane(lane);
+        ++*m_depths[lane];
+        m_lanes[lane]->Push(new_value);
+        m_notempty.Notify();
+    }
+
+    bool TryPush(const SharedPtr<T>& new_value, size_t lane)
+    {
+        lane = clampLane(lane);
+        ++*m_depths[lane];
+        if (!m_lanes[lane]->TryPush(new_value))
+        {
+            --*m_depths[lane];
+            return false;
+        }
+        m_notempty.Notify();
+        return true;
+    }
+
+    void PushBatch(const std::vector<SharedPtr<T> >& values, size_t lane)
+    {
+        if (values.empty())
+        {
+            return;
+        }
+
+        lane = clampLane(lane);
+        *m_depths[lane] += static_cast<int>(values.size());
+        m_lanes[lane]->PushBatch(values);
+        if (values.size() > 1)
+        {
+            m_notempty.NotifyAll();
+        }
+        else
+        {
+            m_notempty.Notify();
+        }
+    }
+
+    virtual void Push(const SharedPtr<T>& new_value)
+    {
+        Push(new_value, m_defaultlane);
+    }
+
+    virtual bool TryPush(const SharedPtr<T>& new_value)
+    {
+        return TryPush(new_value, m_defaultlane);
+    }
+
+    virtual void PushBatch(const std::vector<SharedPtr<T> >& values)
+    {
+        PushBatch(values, m_defaultlane);
+    }
+
+    virtual SharedPtr<T> TryPop()
+    {
+        SharedPtr<T> value;
+        if (m_aging > 0 && ++m_pops >= m_aging)
+        {
+            m_pops = 0;
+            for (size_t lane = m_lanes.size(); lane-- > 0 && !value; )
+            {
+                value = popLane(lane);
+            }
+        }
+        else
+        {
+            for (size_t lane = 0; lane < m_lanes.size() && !value; ++lane)
+            {
+                value = popLane(lane);
+            }
+        }
+        return value;
+    }
+
+    virtual SharedPtr<T> Pop()
+    {
+        SharedPtr<T> value;
+        waitPop(value, 0);
+        return value;
+    }
+
+    virtual SharedPtr<T> TimedPop(const Time& timeout)
+    {
+        SharedPtr<T> value;
+        waitPop(value, &timeout);
+        return value;
+    }
+
+    // Takes the first element as TryPop() does, then fills up from the
+    // most urgent lanes.
+    virtual size_t PopBatch(std::vector<SharedPtr<T> >& values, size_t max_count, const Time& timeout)
+    {
+        if (0 == max_count)
+        {
+            return 0;
+        }
+
+        SharedPtr<T> value = TryPop();
+        if (!value && (timeout <= Time() || !waitPop(value, &timeout)))
+        {
+            return 0;
+        }
+        values.push_back(value);
+
+        size_t popped = 1;
+        for (size_t lane = 0; lane < m_lanes.size() && popped < max_count; ++lane)
+        {
+            size_t count = m_lanes[lane]->PopBatch(values, max_count - popped, Time());
+            *m_depths[lane] -= static_cast<int>(count);
+            popped += count;
+        }
+        return popped;
+    }
+
+    virtual bool Empty()
+    {
+        for (size_t lane = 0; lane < m_lanes.size(); ++lane)
+        {
+            if (!m_lanes[lane]->Empty())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    size_t clampLane(size_t lane) const
+    {
+        return lane < m_lanes.size() ? lane : m_lanes.size() - 1;
+    }
+
+    SharedPtr<T> popLane(size_t lane)
+    {
+        SharedPtr<T> value = m_lanes[lane]->TryPop();
+        if (value)
+        {
+            --*m_depths[lane];
+        }
+        return value;
+    }
+
+    bool waitPop(SharedPtr<T>& value, const Time* timeout)
+    {
+        Time deadline;
+        if (timeout)
+        {
+            deadline = Time::Now(Time::Monotonic) + *timeout;
+        }
+
+        while (!(value = TryPop()))
+        {
+            EventCount::Key key = m_notempty.PrepareWait();
+            if ((value = TryPop()))
+            {
+                m_notempty.CancelWait();
+                break;
+            }
+
+            if (!timeout)
+            {
+                m_notempty.Wait(key);
+                continue;
+            }
+
+            Time remaining = deadline - Time::Now(Time::Monotonic);
+            if (remaining <= Time())
+            {
+                m_notempty.CancelWait();
+                return false;
+            }
+            m_notempty.TimedWait(key, remaining);
+        }
+        return true;
+    }
+
+    std::vector<AbstractQueue<T>*> m_lanes;
+    std::vector<AtomicInt*> m_depths;
+    const size_t m_defaultlane;
+    const int m_aging;
+    AtomicInt m_pops;
+    EventCount m_notempty;
+};
+
+THREADING_END
+
+#endif
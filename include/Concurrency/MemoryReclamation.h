@@ -0,0 +1,322 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_MEMORY_RECLAMATION_H
+#define CONCURRENCY_MEMORY_RECLAMATION_H
+
+#include <vector>
+#include <Config.h>
+#include <Util/Atomic.h>
+#include <Concurrency/Mutex.h>
+
+THREADING_BEGIN
+
+//
+// Safe memory reclamation for lock-free structures.
+//
+// A node unlinked from a lock-free structure may still be read by the
+// threads that loaded a pointer to it before. Instead of deleting it, the
+// thread that unlinked it retires it to a domain, which deletes it once no
+// thread can reach it any more:
+//
+//   - HazardPointerDomain: a reader publishes the pointers it is about to
+//     dereference in HazardPointer objects, the retired nodes that no
+//     hazard pointer refers to are deleted.
+//
+//   - EpochDomain: a reader accesses the structure inside an EpochGuard,
+//     the retired nodes are deleted once every thread left the guards it
+//     was in when they were retired. Cheaper for the readers, but a thread
+//     blocked in a guard holds back all the reclamation of the domain.
+//
+// Each thread keeps its retired nodes in a list of its own and scans it
+// once it holds Threshold nodes, or on Reclaim(). A thread that exits
+// deletes what it can and hands the rest over to the next thread that
+// scans: a Threading::Thread once its Run() returned, other threads only
+// on POSIX, where the ThreadLocal destructors run.
+//
+// A domain must outlive the threads using it, or at least their use of it:
+// destroying it deletes every node retired to it.
+//
+
+template<typename T> class ThreadLocal;
+
+namespace internal
+{
+
+struct RetiredObject
+{
+    void* m_object;
+    void (*m_deleter)(void*);
+    unsigned int m_epoch;       // EpochDomain only.
+};
+
+template<typename T>
+void DeleteRetired(void* object)
+{
+    delete static_cast<T*>(object);
+}
+
+//
+// The part of a thread in a domain. A record is reused by another thread
+// once its thread exited, it is only deleted along with the domain.
+//
+struct ReclaimRecord
+{
+    ReclaimRecord* m_next;
+    volatile int m_inUse;
+    volatile unsigned int m_state;  // EpochDomain only, see EpochDomain::enter.
+    int m_guards;                   // EpochDomain only, nested guards.
+    std::vector<RetiredObject> m_retired;
+};
+
+class ReclaimRecordHandle;
+
+//
+// The per-thread retire lists common to both domains.
+//
+class THREADING_API ReclaimDomain : private noncopyable
+{
+public:
+
+    enum
+    {
+        Threshold = 64
+    };
+
+    virtual ~ReclaimDomain();
+
+    // Deletes object, with deleter, once no thread can reach it.
+    void Retire(void* object, void (*deleter)(void*));
+
+    template<typename T>
+    void Retire(T* object)
+    {
+        Retire(object, &DeleteRetired<T>);
+    }
+
+    // Deletes the objects retired by the calling thread that can be.
+    void Reclaim();
+
+protected:
+
+    ReclaimDomain();
+
+    // The record of the calling thread.
+    ReclaimRecord* record();
+
+    //
+    // Deletes every object retired; called first by the destructor of
+    // the derived classes, which scan() the list of the calling thread.
+    //
+    void shutdown();
+
+    ReclaimRecord* records() const
+    {
+        return AtomicLoad(&m_records, MemoryOrderAcquire);
+    }
+
+    virtual unsigned int retireEpoch() = 0;
+
+    // Deletes the objects of retired no thread can reach, keeps the others.
+    virtual void scan(std::vector<RetiredObject>& retired) = 0;
+
+    static void deleteRetired(std::vector<RetiredObject>& retired);
+
+private:
+
+    friend class ReclaimRecordHandle;
+
+    void reclaim(ReclaimRecord* record);
+    void exitThread(ReclaimRecord* record);
+
+    ReclaimRecord* volatile m_records;
+    ThreadLocal<ReclaimRecordHandle>* m_handles;
+
+    Threading::Mutex m_mutex;
+    std::vector<RetiredObject> m_orphans;   // Left by the threads that exited.
+    volatile int m_hasOrphans;
+};
+
+struct HazardRecord
+{
+    HazardRecord* m_next;
+    volatile int m_inUse;
+    const void* volatile m_pointer;
+};
+
+}
+
+//
+// class HazardPointerDomain
+//
+// Retired objects are deleted once no HazardPointer of the domain refers
+// to them.
+//
+class THREADING_API HazardPointerDomain : public internal::ReclaimDomain
+{
+public:
+
+    HazardPointerDomain();
+
+    ~HazardPointerDomain();
+
+    // The domain of the hazard pointers constructed without one.
+    static HazardPointerDomain& Default();
+
+protected:
+
+    virtual unsigned int retireEpoch();
+    virtual void scan(std::vector<internal::RetiredObject>& retired);
+
+private:
+
+    friend class HazardPointer;
+
+    internal::HazardRecord* acquire();
+    static void release(internal::HazardRecord* record);
+
+    internal::HazardRecord* volatile m_hazards;
+};
+
+//
+// class HazardPointer
+//
+// Protects one object of a domain from being deleted, for as long as it
+// refers to it:
+//
+//   HazardPointer hazard;
+//   Node* head = hazard.Protect(m_head);
+//   ... head may be dereferenced here, even if another thread retires it.
+//
+// A HazardPointer belongs to the thread that constructed it.
+//
+class THREADING_API HazardPointer : private noncopyable
+{
+public:
+
+    explicit HazardPointer(HazardPointerDomain& domain = HazardPointerDomain::Default());
+
+    ~HazardPointer();
+
+    //
+    // Loads source and protects the object loaded, which is still the
+    // value of source when it returns.
+    //
+    template<typename T>
+    T* Protect(const AtomicPtr<T>& source)
+    {
+        T* pointer = source.Load(MemoryOrderRelaxed);
+        for (;;)
+        {
+            Set(pointer);
+            T* current = source.Load();
+            if (current == pointer)
+            {
+                return pointer;
+            }
+            pointer = current;
+        }
+    }
+
+    template<typename T>
+    T* Protect(T* const volatile& source)
+    {
+        T* pointer = AtomicLoad(&source, MemoryOrderRelaxed);
+        for (;;)
+        {
+            Set(pointer);
+            T* current = AtomicLoad(&source);
+            if (current == pointer)
+            {
+                return pointer;
+            }
+            pointer = current;
+        }
+    }
+
+    //
+    // Protects pointer; the caller must then check that it is still
+    // reachable before dereferencing it.
+    //
+    void Set(const void* pointer)
+    {
+        AtomicStore(&m_record->m_pointer, pointer);
+    }
+
+    void Clear()
+    {
+        AtomicStore(&m_record->m_pointer, static_cast<const void*>(0), MemoryOrderRelease);
+    }
+
+private:
+
+    internal::HazardRecord* m_record;
+};
+
+//
+// class EpochDomain
+//
+// Retired objects are deleted once every thread that was in an EpochGuard
+// of the domain when they were retired left it.
+//
+class THREADING_API EpochDomain : public internal::ReclaimDomain
+{
+public:
+
+    EpochDomain();
+
+    ~EpochDomain();
+
+    // The domain of the guards constructed without one.
+    static EpochDomain& Default();
+
+protected:
+
+    virtual unsigned int retireEpoch();
+    virtual void scan(std::vector<internal::RetiredObject>& retired);
+
+private:
+
+    friend class EpochGuard;
+
+    internal::ReclaimRecord* enter();
+    static void leave(internal::ReclaimRecord* record);
+
+    bool tryAdvance();
+
+    volatile unsigned int m_epoch;
+};
+
+//
+// class EpochGuard
+//
+// The objects of a domain reached while a guard is alive are not deleted
+// before it is destroyed. Guards may be nested.
+//
+class THREADING_API EpochGuard : private noncopyable
+{
+public:
+
+    explicit EpochGuard(EpochDomain& domain = EpochDomain::Default()) :
+        m_record(domain.enter())
+    {
+    }
+
+    ~EpochGuard()
+    {
+        EpochDomain::leave(m_record);
+    }
+
+private:
+
+    internal::ReclaimRecord* m_record;
+};
+
+THREADING_END
+
+#endif
@@ -0,0 +1,393 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_RING_QUEUE_H
+#define CONCURRENCY_RING_QUEUE_H
+
+#include <Config.h>
+#include <vector>
+#include <Concurrency/EventCount.h>
+#include <Util/SharedPtr.h>
+#include <Util/Exception.h>
+#include <Util/Time.h>
+#include <Util/Atomic.h>
+
+THREADING_BEGIN
+
+//
+// Bounded multi-producer/multi-consumer queue on a fixed ring of cells
+// (D. Vyukov's sequence number design).
+//
+// Every cell carries a sequence number that tells producers and consumers
+// whose turn it is, so Push and Pop cost one CAS on the enqueue or dequeue
+// position and never allocate: the ring is allocated once and the values
+// are intrusive SharedPtr's. The two positions live on separate cache lines.
+//
+// The blocking operations only go through an EventCount when the queue is
+// empty (Pop) or full (Push); the opposite side then pays one fence and one
+// load to see whether somebody sleeps. The capacity is rounded up to a
+// power of two.
+//
+template<class T>
+class RingQueue : public noncopyable
+{
+public:
+    typedef T value_type;
+
+    explicit RingQueue(size_t capacity = 1024) :
+        m_buffer(0),
+        m_mask(roundUp(capacity) - 1),
+        m_enqueuepos(0),
+        m_dequeuepos(0)
+    {
+        if (capacity < 1)
+        {
+            throw IllegalArgumentException(__FILE__, __LINE__, "RingQueue capacity must be positive");
+        }
+
+        m_buffer = new Cell[m_mask + 1];
+        for (size_t i = 0; i <= m_mask; ++i)
+        {
+            m_buffer[i].m_sequence.Store(i, MemoryOrderRelaxed);
+        }
+    }
+
+    ~RingQueue()
+    {
+        delete [] m_buffer;
+    }
+
+    SharedPtr<T> TryPop()
+    {
+        SharedPtr<T> result;
+        if (dequeue(result))
+        {
+            m_notfull.Notify();
+        }
+        return result;
+    }
+
+    bool TryPop(T& value)
+    {
+        SharedPtr<T> result = TryPop();
+        if (!result)
+        {
+            return false;
+        }
+        value = *result;
+        return true;
+    }
+
+    SharedPtr<T> Pop()        // Wait And Pop
+    {
+        SharedPtr<T> result;
+        waitPop(result, 0);
+        return result;
+    }
+
+    void Pop(T& value)        // Wait And Pop
+    {
+        value = *Pop();
+    }
+
+    SharedPtr<T> TimedPop(const Time& timeout)            // Timed Wait And Pop
+    {
+        SharedPtr<T> result;
+        waitPop(result, &timeout);
+        return result;
+    }
+
+    bool TimedPop(T& value, const Time& timeout)        // Timed Wait And Pop
+    {
+        SharedPtr<T> result = TimedPop(timeout);
+        if (!result)
+        {
+            return false;
+        }
+        value = *result;
+        return true;
+    }
+
+    void Push(const T& new_value)        // Wait And Push
+    {
+        Push(SharedPtr<T>(new T(new_value)));
+    }
+
+    void Push(const SharedPtr<T>& new_value)        // Wait And Push
+    {
+        waitPush(new_value, 0);
+    }
+
+    bool TryPush(const SharedPtr<T>& new_value)
+    {
+        if (!enqueue(new_value))
+        {
+            return false;
+        }
+        m_notempty.Notify();
+        return true;
+    }
+
+    bool TimedPush(const SharedPtr<T>& new_value, const Time& timeout)        // Timed Wait And Push
+    {
+        return waitPush(new_value, &timeout);
+    }
+
+    // Wakes the consumers once for the whole range; blocks while full.
+    template<typename InputIterator>
+    void PushBatch(InputIterator first, InputIterator last)
+    {
+        size_t pushed = 0;
+        for (; first != last; ++first)
+        {
+            if (enqueue(*first))
+            {
+                ++pushed;
+                continue;
+            }
+
+            notifyConsumers(pushed);
+            pushed = 0;
+            waitPush(*first, 0);
+        }
+        notifyConsumers(pushed);
+    }
+
+    // Appends up to max_count elements to values. Waits up to timeout
+    // for the first one; a zero timeout doesn't wait.
+    size_t PopBatch(std::vector<SharedPtr<T> >& values, size_t max_count, const Time& timeout)
+    {
+        if (0 == max_count)
+        {
+            return 0;
+        }
+
+        SharedPtr<T> value;
+        if (!dequeue(value) && (timeout <= Time() || !waitPop(value, &timeout)))
+        {
+            return 0;
+        }
+
+        size_t popped = 0;
+        do
+        {
+            values.push_back(SharedPtr<T>());
+            values.back().Swap(value);
+            ++popped;
+        } 
+        while (popped < max_count && dequeue(value));
+
+        value = 0;
+        if (popped > 1)
+        {
+            m_notfull.NotifyAll();
+        }
+        else
+        {
+            m_notfull.Notify();
+        }
+        return popped;
+    }
+
+    bool Empty() const
+    {
+        return m_dequeuepos == m_enqueuepos;
+    }
+
+    size_t Size() const
+    {
+        size_t dequeuepos = m_dequeuepos;
+        size_t enqueuepos = m_enqueuepos;
+        return enqueuepos > dequeuepos ? enqueuepos - dequeuepos : 0;
+    }
+
+    size_t Capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    struct Cell
+    {
+        Atomic<size_t>     m_sequence;
+        SharedPtr<T>       m_data;
+    };
+
+    static size_t roundUp(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    void notifyConsumers(size_t pushed)
+    {
+        if (pushed > 1)
+        {
+            m_notempty.NotifyAll();
+        }
+        else if (pushed > 0)
+        {
+            m_notempty.Notify();
+        }
+    }
+
+    bool enqueue(const SharedPtr<T>& value)
+    {
+        Cell* cell;
+        size_t pos = m_enqueuepos.Load(MemoryOrderRelaxed);
+        for (;;)
+        {
+            cell = &m_buffer[pos & m_mask];
+            size_t seq = cell->m_sequence.Load(MemoryOrderAcquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+            if (0 == diff)
+            {
+                if (m_enqueuepos.CompareExchange(pos, pos + 1, MemoryOrderRelaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;       // full
+            }
+            else
+            {
+                pos = m_enqueuepos.Load(MemoryOrderRelaxed);
+            }
+        }
+
+        cell->m_data = value;
+        cell->m_sequence.Store(pos + 1, MemoryOrderRelease);
+        return true;
+    }
+
+    bool dequeue(SharedPtr<T>& value)
+    {
+        Cell* cell;
+        size_t pos = m_dequeuepos.Load(MemoryOrderRelaxed);
+        for (;;)
+        {
+            cell = &m_buffer[pos & m_mask];
+            size_t seq = cell->m_sequence.Load(MemoryOrderAcquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+            if (0 == diff)
+            {
+                if (m_dequeuepos.CompareExchange(pos, pos + 1, MemoryOrderRelaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;       // empty
+            }
+            else
+            {
+                pos = m_dequeuepos.Load(MemoryOrderRelaxed);
+            }
+        }
+
+        value.Swap(cell->m_data);
+        cell->m_data = 0;
+        cell->m_sequence.Store(pos + m_mask + 1, MemoryOrderRelease);
+        return true;
+    }
+
+    bool waitPop(SharedPtr<T>& value, const Time* timeout)
+    {
+        Time deadline;
+        if (timeout)
+        {
+            deadline = Time::Now(Time::Monotonic) + *timeout;
+        }
+
+        while (!dequeue(value))
+        {
+            EventCount::Key key = m_notempty.PrepareWait();
+            if (dequeue(value))
+            {
+                m_notempty.CancelWait();
+                break;
+            }
+
+            if (!timeout)
+            {
+                m_notempty.Wait(key);
+                continue;
+            }
+
+            Time remaining = deadline - Time::Now(Time::Monotonic);
+            if (remaining <= Time())
+            {
+                m_notempty.CancelWait();
+                return false;
+            }
+            m_notempty.TimedWait(key, remaining);
+        }
+
+        m_notfull.Notify();
+        return true;
+    }
+
+    bool waitPush(const SharedPtr<T>& value, const Time* timeout)
+    {
+        Time deadline;
+        if (timeout)
+        {
+            deadline = Time::Now(Time::Monotonic) + *timeout;
+        }
+
+        while (!enqueue(value))
+        {
+            EventCount::Key key = m_notfull.PrepareWait();
+            if (enqueue(value))
+            {
+                m_notfull.CancelWait();
+                break;
+            }
+
+            if (!timeout)
+            {
+                m_notfull.Wait(key);
+                continue;
+            }
+
+            Time remaining = deadline - Time::Now(Time::Monotonic);
+            if (remaining <= Time())
+            {
+                m_notfull.CancelWait();
+                return false;
+            }
+            m_notfull.TimedWait(key, remaining);
+        }
+
+        m_notempty.Notify();
+        return true;
+    }
+
+    char m_pad0[CACHE_LINE_SIZE];
+    Cell* m_buffer;
+    const size_t m_mask;
+    char m_pad1[CACHE_LINE_SIZE];
+    Atomic<size_t> m_enqueuepos;
+    char m_pad2[CACHE_LINE_SIZE];
+    Atomic<size_t> m_dequeuepos;
+    char m_pad3[CACHE_LINE_SIZE];
+
+    EventCount m_notempty;
+    EventCount m_notfull;
+};
+
+THREADING_END
+
+#endif
@@ -29,6 +29,10 @@ public:
     ThreadControl Start(size_t stack_size = 0);
     ThreadControl Start(size_t stack_size, int priority);
 
+    // As above, the thread being pinned to cpus unless cpus is empty.
+    ThreadControl Start(size_t stack_size, const CpuSet& cpus);
+    ThreadControl Start(size_t stack_size, int priority, const CpuSet& cpus);
+
     ThreadControl GetThreadControl() const;
 
     bool operator ==(const Thread&) const;
@@ -60,16 +64,31 @@ protected:
 
 private:
 
-#ifdef _WIN32
+#if defined(LANG_CPP11)
     // nothing
+#elif defined(_WIN32)
+    ThreadControl Start(size_t stack_size, int priority, const CpuSet* cpus);
 #else
-    ThreadControl Start(size_t stack_size, bool realtime_scheduling, int priority);
+    ThreadControl Start(size_t stack_size, bool realtime_scheduling, int priority, const CpuSet* cpus);
 #endif
 
 };
 
 typedef SharedPtr<Thread> ThreadPtr;
 
+namespace internal
+{
+
+//
+// Adds hook, called by every thread started by Thread once its Run()
+// returned, the last added first. It releases the per-thread state of a
+// module, held in ThreadLocals whose destructors never run on Windows.
+// Only called during static initialization.
+//
+THREADING_API void AddThreadExitHook(void (*hook)());
+
+}
+
 THREADING_END
 
 #endif
\ No newline at end of file
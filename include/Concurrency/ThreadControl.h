@@ -11,6 +11,7 @@
 
 #include <Config.h>
 #include <Util/Time.h>
+#include <Concurrency/CpuSet.h>
 #include <Build/UndefSysMacros.h>
 
 #ifdef LANG_CPP11
@@ -48,10 +49,19 @@ public:
 
     ID Id() const;
 
+    //
+    // Restricts the thread to the CPUs of cpus. A no-op where threads
+    // can't be pinned (Mac OS X); on Windows only the first 64 CPUs count.
+    //
+    void SetAffinity(const CpuSet& cpus);
+
     static void Sleep(const Time& timeout);
 
     static void Yield();
 
+    // Tells the CPU that the caller is busy-waiting.
+    static void Pause();
+
 private:
 
 #ifdef LANG_CPP11
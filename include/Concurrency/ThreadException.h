@@ -154,6 +154,28 @@ private:
     static const char *ms_pcName;
 };
 
+class THREADING_API FutureException : public Exception
+{
+public:
+    FutureException(const char *file, int line, const std::string& reason);
+    virtual ~FutureException(void) throw();
+
+    virtual std::string Name() const;
+
+    virtual void Print(std::ostream& out) const;
+
+    virtual Exception* Clone() const;
+
+    virtual void Throw() const;
+
+    const std::string& Reason() const;
+
+private:
+
+    std::string                 m_reason;
+    static const char *ms_pcName;
+};
+
 THREADING_END
 
 #endif
\ No newline at end of file
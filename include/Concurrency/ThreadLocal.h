@@ -88,6 +88,23 @@ public:
         return GetOrCreateValue();
     }
 
+    // The value of the calling thread, or null if it never used it.
+    T* Find() const
+    {
+#ifdef _WIN32
+        ThreadLocalValueHolderBase* const holder = 
+            static_cast<ThreadLocalValueHolderBase*>(TlsGetValue(m_key));
+#elif HAS_PTHREAD
+        ThreadLocalValueHolderBase* const holder =
+            static_cast<ThreadLocalValueHolderBase*>(pthread_getspecific(m_key));
+#endif
+        if (NULL == holder)
+        {
+            return NULL;
+        }
+        return Threading::CheckedDowncastToActualType<ValueHolder>(holder)->Pointer();
+    }
+
     const T& Get() const 
     { 
         return *Pointer(); 
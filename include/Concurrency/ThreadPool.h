@@ -10,14 +10,27 @@
 #define CONCURRENCY_THREAD_POOL_H
 
 #include <Config.h>
+#include <new>
+#include <vector>
 #include <Concurrency/Runnable.h>
 #include <Concurrency/Thread.h>
+#include <Concurrency/CpuSet.h>
 #include <Concurrency/ThreadSafeQueue.h>
+#include <Concurrency/RingQueue.h>
+#include <Concurrency/AbstractQueue.h>
+#include <Concurrency/LaneQueue.h>
 #include <Concurrency/ThreadSafeList.h>
+#include <Concurrency/WorkStealingQueue.h>
+#include <Concurrency/ThreadLocal.h>
+#include <Concurrency/EventCount.h>
 #include <Concurrency/Monitor.h>
+#include <Concurrency/Timer.h>
 #include <Util/Atomic.h>
+#include <Util/BiasedShared.h>
+#include <Util/UniquePtr.h>
 #include <Util/Properties.h>
 #include <Logging/LoggerUtil.h>
+#include <Logging/LogRateLimit.h>
 
 THREADING_BEGIN
 
@@ -25,93 +38,49 @@ void ThreadJoiner(const ThreadPtr& thread);
 
 //////////////////////////////////////////////////////////////////////////
 /// class TaskBase
+//
+// The monitor that WaitDone()/TimedWaitDone() block on is only created by
+// the first waiter, so a task nobody waits for owns no mutex or condition
+// variable and NotifyDone() is a store and a fence.
+//
 class THREADING_API TaskBase : public Threading::Runnable
     , virtual public Threading::Shared
-    , public Threading::Monitor<Threading::Mutex>
 {
 public:
     TaskBase(const std::string& name) : m_name(name)
         , m_done(false)
+        , m_waiters(0)
+        , m_monitor(0)
     {
     }
 
-    virtual ~TaskBase() {}
-
-    const std::string& Name() const
+    virtual ~TaskBase()
     {
-        return m_name;
+        delete m_monitor;
     }
 
-    void Reset()
-    {
-        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
-        m_done = false;
-        m_waiters = 0;
-    }
-
-    void WaitDone() const
+    const std::string& Name() const
     {
-        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
-        while (!m_done)
-        {
-            try 
-            {
-                ++m_waiters;
-                Wait();
-                --m_waiters;
-            } 
-            catch (...) 
-            {
-                --m_waiters;
-                throw;
-            }
-        }
+        return m_name;
     }
 
-    bool TimedWaitDone(const Time& timeout) const
-    {
-        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
-
-        if (m_done)
-        {
-            return true;
-        }
-
-        bool returnVal = false;
-
-        try 
-        {
-            ++m_waiters;
-            returnVal = TimedWait(timeout);
-            --m_waiters;
-        } 
-        catch (...) 
-        {
-            --m_waiters;
-            throw;
-        }
+    void Reset();
 
-        return returnVal;
-    }
+    void WaitDone() const;
 
-    void NotifyDone() const
-    {
-        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
-        m_done = true;
+    bool TimedWaitDone(const Time& timeout) const;
 
-        if (0 != m_waiters)
-        {
-            //Notify();
-            NotifyAll();
-        }
-    }
+    void NotifyDone() const;
 
 protected:
     const std::string m_name;
 
 private:
-    mutable bool    m_done;
+    Threading::Monitor<Threading::Mutex>* getMonitor() const;
+
+    mutable volatile bool m_done;
     mutable int        m_waiters;
+    mutable Threading::Monitor<Threading::Mutex>* volatile m_monitor;
 };
 
 typedef SharedPtr<TaskBase> TaskPtr;
@@ -146,6 +115,117 @@ protected:
 
 
 
+//////////////////////////////////////////////////////////////////////////
+/// class SmallTask
+//
+// Task for small callables: a function object of up to
+// SMALL_TASK_INLINE_SIZE bytes is stored inside the task instead of on
+// the heap, and the tasks themselves are recycled through per-thread free
+// lists. A task freed by another thread, e.g. the worker that ran it,
+// goes back to the list of the thread that allocated it, so a producer
+// that keeps submitting usually allocates nothing. Bigger function
+// objects still work, they are just copied to the heap.
+//
+//     pool->SubmitTask(new SmallTask(Flush(connection)));
+//
+#define SMALL_TASK_INLINE_SIZE 48
+
+template<typename F, bool Inline = (sizeof(F) <= SMALL_TASK_INLINE_SIZE)>
+struct SmallTaskOps
+{
+    static void Construct(void* storage, const F& fun)
+    {
+        new (storage) F(fun);
+    }
+
+    static void Invoke(void* storage)
+    {
+        (*static_cast<F*>(storage))();
+    }
+
+    static void Destroy(void* storage)
+    {
+        static_cast<F*>(storage)->~F();
+    }
+};
+
+template<typename F>
+struct SmallTaskOps<F, false>
+{
+    static void Construct(void* storage, const F& fun)
+    {
+        *static_cast<F**>(storage) = new F(fun);
+    }
+
+    static void Invoke(void* storage)
+    {
+        (**static_cast<F**>(storage))();
+    }
+
+    static void Destroy(void* storage)
+    {
+        delete *static_cast<F**>(storage);
+    }
+};
+
+class THREADING_API SmallTask : public TaskBase
+{
+public:
+    template<typename F>
+    explicit SmallTask(F fun) : TaskBase("")
+        , m_invoke(&SmallTaskOps<F>::Invoke)
+        , m_destroy(&SmallTaskOps<F>::Destroy)
+    {
+        SmallTaskOps<F>::Construct(m_storage.m_bytes, fun);
+    }
+
+    SmallTask(void (*fun)(void *), void *param, const std::string& name = "") : TaskBase(name)
+        , m_invoke(&SmallTaskOps<Callback>::Invoke)
+        , m_destroy(&SmallTaskOps<Callback>::Destroy)
+    {
+        SmallTaskOps<Callback>::Construct(m_storage.m_bytes, Callback(fun, param));
+    }
+
+    virtual ~SmallTask()
+    {
+        m_destroy(m_storage.m_bytes);
+    }
+
+    virtual void Run()
+    {
+        m_invoke(m_storage.m_bytes);
+    }
+
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
+
+private:
+    struct Callback
+    {
+        Callback(void (*fun)(void *), void *param) : m_fun(fun), m_param(param)
+        {
+        }
+
+        void operator()()
+        {
+            m_fun(m_param);
+        }
+
+        void (*m_fun)(void *);
+        void *m_param;
+    };
+
+    void (*m_invoke)(void*);
+    void (*m_destroy)(void*);
+    union
+    {
+        char m_bytes[SMALL_TASK_INLINE_SIZE];
+        long double m_alignld;
+        Int64 m_align64;
+        void* m_alignptr;
+    } m_storage;
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// class JoinThreads
 class THREADING_API JoinThreads
@@ -169,36 +249,110 @@ private:
     std::set<ThreadPtr>& m_threads;
 };
 
+class TaskThread;
+class IdleThreadShrinker;
+template<typename T> class Future;
+template<typename F> struct CallableResult;
+
 //////////////////////////////////////////////////////////////////////////
 /// class ThreadPool
 class THREADING_API ThreadPool : public Threading::Shared, public Threading::Monitor<Threading::Mutex>
 {
     friend class TaskThread;
+    friend class IdleThreadShrinker;
 public:
     ThreadPool(int threadnum = 2, const std::string& poolname = "", const std::string& logger_file = "");
 
+    // logger_file is rotated as <pool>.Log.MaxSize, .MaxAge and .Keep say, see LogRotation::Load.
     ThreadPool(const std::string& properties_file, const std::string& logger_file = "", const std::string& poolname = "");
 
     ~ThreadPool(void);
 
     void Reset();
 
+    //
+    // With <pool>.TaskQueue=ring, SubmitTask blocks while the ring is
+    // full, except on a worker of this pool: a worker that waits for room
+    // may be waiting for itself, so it runs the task there and then.
+    //
     void SubmitTask(const TaskPtr& task);
 
     TaskPtr SubmitTask(void (*fun)(void *), void *param = NULL);
 
+    //
+    // Submits task to the priority lane `priority', 0 being the most
+    // urgent; see <pool>.TaskLanes. Without lanes it is SubmitTask(task).
+    //
+    void SubmitTask(const TaskPtr& task, int priority);
+
+    //
+    // Submits all the tasks with a single push to the queue and a single
+    // update of the pool's bookkeeping.
+    //
+    void SubmitTasks(const std::vector<TaskPtr>& tasks);
+
+    template<typename InputIterator>
+    void SubmitTasks(InputIterator first, InputIterator last)
+    {
+        SubmitTasks(std::vector<TaskPtr>(first, last));
+    }
+
+    //
+    // Runs fun() on the pool and returns the future of its result; see
+    // Future.h. fun is a function pointer or a function object with a
+    // result_type.
+    //
+    template<typename F>
+    Future<typename CallableResult<F>::type> Submit(F fun);
+
     void JoinAll();
 
+    // How long a parked worker stays idle before it may be retired.
     void SetThreadIdleTime(const Time& idle_time);
 
+    // Number of tasks waiting in each priority lane, empty without lanes.
+    std::vector<size_t> GetLaneDepths() const;
+
 private:
+    void checkDestroyed();
+
+    void tasksSubmitted(size_t count);
+
+    void taskFailed(const char* type);
+
+    bool pushTask(const TaskPtr& task, int lane);
+
+    void runInline(const TaskPtr& task);
+
+    TaskPtr stealTask(size_t thief);
+
+    CpuSet workerCpus(size_t index) const;
+
+    WorkStealingQueue<TaskBase>* localQueue(size_t index);
+
+    void parkWorker(TaskThread* worker);
+
+    bool unparkWorker(TaskThread* worker);
+
+    void wakeWorkers(size_t count);
+
+    bool tasksPending();
+
+    size_t nextWorkerIndex();
+
+    void startShrinker();
+
+    void shrink();
+
     //Note that the order of declaration of the members is important:
     //   both the m_destroyed flag and the m_tasksqueue must be declared before the m_threads vector,
     //   which must in turn be declared before the m_joiner. This ensures that the members are
     //   destroyed in the right order; you can't destroy the queue safely until all the threads
     //   have stopped, for example.
     AtomicBool m_destroyed;
-    ThreadSafeQueue<TaskBase> m_tasksqueue;
+    UniquePtr<AbstractQueue<TaskBase> > m_tasksqueue;   // Global (injection) queue.
+    LaneQueue<TaskBase>* m_lanequeue;   // m_tasksqueue if it has priority lanes, otherwise 0.
+    std::vector<WorkStealingQueue<TaskBase>*> m_localqueues;   // Per-worker deques, work-stealing scheduler only; 0 until a pinned worker allocates its own.
     std::set<ThreadPtr> m_threads;                   // All threads, running or not.
     JoinThreads m_joiner;
 
@@ -206,40 +360,83 @@ private:
     const size_t m_sizemax;     // Maximum number of threads.
     const size_t m_sizewarn;    // If m_inuse reaches m_sizeWarn, a "low on threads" warning will be printed.
     AtomicInt m_inuse;          // Number of threads that are currently in use.
+    AtomicInt m_idlethreads;    // Number of threads that are parked waiting for a task.
+    std::vector<TaskThread*> m_parked;      // Parked threads, the most recently parked last.
+    Threading::Mutex m_parkedmutex;
 
-    const bool m_waitifnotask;      // If the task queue has no task to execute, let idle thread wait.
     const bool m_haspriority;
-    const Int64 m_shrinkcycletime;   // sleep time(second) of shrink thread.
-    const Int64 m_threadidletime;    // idle thread wait time(millisecond).
+    const bool m_workstealing;      // Workers keep a local deque and steal from each other.
+    const bool m_boundedqueue;      // m_tasksqueue may be full (TaskQueue=ring).
+    const size_t m_batchsize;       // Maximum number of tasks a worker takes from the queue per wakeup.
+    const int m_spincount;          // Idle rounds a worker spins before it yields.
+    const int m_yieldcount;         // Idle rounds a worker yields before it parks, < 0 never parks.
+    const Int64 m_shrinkcycletime;   // sleep time(second) of shrink thread, 0 never shrinks.
+    const Int64 m_threadidletime;    // Parked time (millisecond) before a worker may be retired, 0 a shrink cycle.
     const int m_priority;
     const size_t m_stacksize;
+    std::vector<CpuSet> m_workercpus;   // Worker i is pinned to m_workercpus[i % size], not pinned if empty.
 
     PropertiesPtr m_properties;
     LoggerPtr m_logger;
     std::string m_poolname;
+    LogSite m_lowthreadslog;        // Rate limits of the warnings and errors logged repeatedly.
+    LogSite m_taskerrorlog;
+    LogSite m_destroyedlog;
+
+    ThreadLocal<int> m_workerindex; // Index of the calling worker (of its local deque), -1 for other threads.
+    std::vector<size_t> m_freeindexes;  // Indexes of retired workers, reused by new ones.
+    TimerPtr m_shrinktimer;
 };
 
 typedef Threading::SharedPtr<ThreadPool> ThreadPoolPtr;
 
+//////////////////////////////////////////////////////////////////////////
+/// class IdleThreadShrinker
+//
+// Runs every ShrinkCycleTime seconds on the pool's timer and retires the
+// workers that have been parked for longer than ThreadIdleTime, as long as
+// more than Size threads are left.
+//
+class IdleThreadShrinker : public TimerTask
+{
+public:
+    explicit IdleThreadShrinker(ThreadPool& thread_pool) : m_threadpool(thread_pool)
+    {
+    }
+
+    virtual void RunTimerTask()
+    {
+        m_threadpool.shrink();
+    }
+
+private:
+    ThreadPool& m_threadpool;
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// class TaskThread
 class TaskThread : virtual public Shared, virtual public Thread
 {
     friend class IdleThreadShrinker;
+    friend class ThreadPool;
 public:
-    TaskThread(ThreadPool& thread_pool) : 
+    TaskThread(ThreadPool& thread_pool, size_t index) : 
         m_idle(false),
         m_destroyed(false),
+        m_index(index),
+        m_batchnext(0),
+        m_idlerounds(0),
         m_threadpool(thread_pool)
     {
         SetNoDelete(true);
+        CpuSet cpus = m_threadpool.workerCpus(m_index);
         if (m_threadpool.m_haspriority)
         {
-            Start(m_threadpool.m_stacksize, m_threadpool.m_priority);
+            Start(m_threadpool.m_stacksize, m_threadpool.m_priority, cpus);
         }
         else
         {
-            Start(m_threadpool.m_stacksize);
+            Start(m_threadpool.m_stacksize, cpus);
         }
         SetNoDelete(false);
     }
@@ -248,21 +445,46 @@ protected:
 
     virtual void Run()
     {
-        while (!m_destroyed && !m_threadpool.m_destroyed)
+        WorkStealingQueue<TaskBase>* localqueue = 0;
+        if (m_threadpool.m_workstealing)
+        {
+            localqueue = m_threadpool.localQueue(m_index);
+        }
+        m_threadpool.m_workerindex.Set(static_cast<int>(m_index));
+
+        // Tasks already taken from the queue are run even if the pool is being destroyed.
+        while ((!m_destroyed && !m_threadpool.m_destroyed) || m_batchnext < m_batch.size())
         {
             Threading::SharedPtr<TaskBase> task;
-            if (m_threadpool.m_waitifnotask)
+            if (m_batchnext < m_batch.size())
             {
-                task = m_threadpool.m_tasksqueue.TimedPop(Threading::Time::MilliSeconds(m_threadpool.m_threadidletime));
+                task = m_batch[m_batchnext];
+                m_batch[m_batchnext++] = 0;
             }
+            else if (localqueue)
+            {
+                // Own work first (LIFO), then the global injection queue,
+                // then try to steal the oldest work of another worker.
+                task = localqueue->TryPop();
+                if (!task)
+                {
+                    task = popTasks(localqueue, Threading::Time());
+                }
+                if (!task)
+                {
+                    task = m_threadpool.stealTask(m_index);
+                }
+            }
+
             else
             {
-                task = m_threadpool.m_tasksqueue.TryPop();
+                task = popTasks(localqueue, Threading::Time());
             }
 
             if (task)
             {
                 m_idle = false;
+                m_idlerounds = 0;
 
                 try
                 {
@@ -277,26 +499,118 @@ protected:
 
                     --m_threadpool.m_inuse;
 
-                    Error out(m_threadpool.m_logger);
-                    out << "task: " << typeid(task).name() <<" in thread pool `" 
-                        << m_threadpool.m_poolname << "' is running error, "
-                        << "please check the thask's Run() method\n";
+                    m_threadpool.taskFailed(typeid(task).name());
                 }
             }
             else
             {
-                m_idle = true;
-                GetThreadControl().Yield();
+                if (!m_idle)
+                {
+                    m_idle = true;
+                    m_idlesince = Threading::Time::Now(Threading::Time::Monotonic);
+                }
+                idle();
+            }
+        }
+
+        // A retired worker hands what is left in its deque to the others.
+        if (localqueue && !m_threadpool.m_destroyed)
+        {
+            for (Threading::SharedPtr<TaskBase> task = localqueue->TryPop(); task; task = localqueue->TryPop())
+            {
+                m_threadpool.m_tasksqueue->Push(task);
             }
         }
     }
 
 private:
+    //
+    // Takes up to ThreadPool::m_batchsize tasks from the global queue and
+    // returns the first one. The rest go to the worker's own deque, where
+    // other workers can still steal them, or are kept in m_batch.
+    //
+    Threading::SharedPtr<TaskBase> popTasks(WorkStealingQueue<TaskBase>* localqueue, const Threading::Time& timeout)
+    {
+        if (m_threadpool.m_batchsize <= 1)
+        {
+            return timeout > Threading::Time() ? 
+                m_threadpool.m_tasksqueue->TimedPop(timeout) : m_threadpool.m_tasksqueue->TryPop();
+        }
+
+        m_batch.clear();
+        m_batchnext = 0;
+        if (0 == m_threadpool.m_tasksqueue->PopBatch(m_batch, m_threadpool.m_batchsize, timeout))
+        {
+            return Threading::SharedPtr<TaskBase>();
+        }
+
+        Threading::SharedPtr<TaskBase> task = m_batch[0];
+        if (localqueue)
+        {
+            localqueue->PushBatch(m_batch.begin() + 1, m_batch.end());
+            m_batch.clear();
+        }
+        else
+        {
+            m_batch[0] = 0;
+            m_batchnext = 1;
+        }
+        return task;
+    }
+
+    //
+    // One round of the idle strategy: spin, then yield, then park until
+    // SubmitTask wakes this worker or the idle time elapses.
+    //
+    void idle()
+    {
+        ++m_idlerounds;
+        if (m_idlerounds <= m_threadpool.m_spincount)
+        {
+            ThreadControl::Pause();
+            return;
+        }
+
+        if (m_threadpool.m_yieldcount < 0 || m_idlerounds <= m_threadpool.m_spincount + m_threadpool.m_yieldcount)
+        {
+            ThreadControl::Yield();
+            return;
+        }
+
+        // Nothing to run: settle the objects handed back to this thread.
+        BiasedShared::MergeQueued();
+
+        //
+        // Register as parked before the last look at the queues: a task
+        // submitted after that look finds us in the parked list.
+        //
+        EventCount::Key key = m_parking.PrepareWait();
+        m_threadpool.parkWorker(this);
+        if (m_destroyed || m_threadpool.m_destroyed || m_threadpool.tasksPending())
+        {
+            m_threadpool.unparkWorker(this);
+            m_parking.CancelWait();
+            return;
+        }
+
+        m_parking.TimedWait(key, Threading::Time::MilliSeconds(m_threadpool.m_threadidletime > 0 ? m_threadpool.m_threadidletime : 1000));
+        m_threadpool.unparkWorker(this);
+        m_idlerounds = 0;
+    }
+
     bool m_idle;
-    bool m_destroyed;
+    Threading::Time m_idlesince;    // When m_idle was last set.
+    AtomicBool m_destroyed;     // Set by the shrinker, on the timer thread, to retire this worker.
+    const size_t m_index;       // Slot of this worker's deque in ThreadPool::m_localqueues.
+    std::vector<Threading::SharedPtr<TaskBase> > m_batch;     // Tasks taken by popTasks and not run yet.
+    size_t m_batchnext;
+    int m_idlerounds;           // Rounds without a task since the last task or wakeup.
+    EventCount m_parking;       // Where the worker parks when idle.
     ThreadPool& m_threadpool;
 };
 
 THREADING_END
 
+#include <Concurrency/Future.h>
+
 #endif
\ No newline at end of file
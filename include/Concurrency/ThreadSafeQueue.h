@@ -9,21 +9,30 @@
 #ifndef CONCURRENCY_THREAD_SAFE_QUEUE_H
 #define CONCURRENCY_THREAD_SAFE_QUEUE_H
 
-#define  USING_MONITOR
-
-# ifdef USING_MONITOR
-#    include <list>
-#    include <Concurrency/Monitor.h>
-# else
-#    include <Concurrency/Mutex.h>
-#    include <Concurrency/Cond.h>
-#    include <Util/SharedPtr.h>
-#    include <Util/UniquePtr.h>
-# endif
+#include <list>
+#include <vector>
+#include <Concurrency/Monitor.h>
+#include <Concurrency/Mutex.h>
+#include <Concurrency/Cond.h>
+#include <Util/Atomic.h>
+#include <Util/SharedPtr.h>
 
 THREADING_BEGIN
 
-#ifdef USING_MONITOR
+//
+// Locking policies of ThreadSafeQueue, chosen per instantiation:
+//
+//   ThreadSafeQueue<T>                       one Monitor guards a std::list.
+//   ThreadSafeQueue<T, TwoLockQueuePolicy>   linked list with separate head
+//                                            and tail mutexes, so a producer
+//                                            and a consumer don't contend.
+//
+struct MonitorQueuePolicy {};
+struct TwoLockQueuePolicy {};
+
+template<class T, class Policy = MonitorQueuePolicy>
+class ThreadSafeQueue;
+
 //
 // ʵóԱ m_waitingReaders סĶȡߵĿʼΪ㣬 Pop 
 // ʵڵ Wait ֮ǰ֮ʹͼСע⣬Щ䴦 try-catch Уʹ
@@ -38,9 +47,11 @@ THREADING_BEGIN
 // 
 
 template<class T> 
-class ThreadSafeQueue : public Threading::Monitor<Threading::Mutex>
+class ThreadSafeQueue<T, MonitorQueuePolicy> : public Threading::Monitor<Threading::Mutex>
 {
 public:
+    typedef T value_type;
+
     ThreadSafeQueue() : m_waitingReaders(0) {}
 
     SharedPtr<T> TryPop()
@@ -50,7 +61,8 @@ public:
         {
             return SharedPtr<T>();
         }
-        SharedPtr<T> result = m_queue.front();
+        SharedPtr<T> result;
+        result.Swap(m_queue.front());
         m_queue.pop_front();
         return result;
     }
@@ -65,7 +77,7 @@ public:
         //value = std::move(*m_queue.front());
         value = *m_queue.front();
         m_queue.pop_front();
-        return;
+        return true;
     }
 
     SharedPtr<T> Pop()        // Wait And Pop
@@ -85,7 +97,8 @@ public:
                 throw;
             }
         }
-        SharedPtr<T> result = m_queue.front();
+        SharedPtr<T> result;
+        result.Swap(m_queue.front());
         m_queue.pop_front();
         return result;
     }
@@ -143,7 +156,8 @@ public:
             return SharedPtr<T>();
         }
 
-        SharedPtr<T> result = m_queue.front();
+        SharedPtr<T> result;
+        result.Swap(m_queue.front());
         m_queue.pop_front();
         return result;
     }
@@ -204,32 +218,158 @@ public:
         }
     }
 
+    // Never full: always pushes.
+    bool TryPush(const SharedPtr<T>& new_value)
+    {
+        Push(new_value);
+        return true;
+    }
+
+    template<typename InputIterator>
+    void PushBatch(InputIterator first, InputIterator last)
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        size_t pushed = 0;
+        for (; first != last; ++first, ++pushed)
+        {
+            m_queue.push_back(*first);
+        }
+
+        // One Notify per element, up to the number of waiting readers.
+        if (m_waitingReaders > 0 && pushed > 0)
+        {
+            if (pushed >= static_cast<size_t>(m_waitingReaders))
+            {
+                NotifyAll();
+            }
+            else
+            {
+                while (pushed-- > 0)
+                {
+                    Notify();
+                }
+            }
+        }
+    }
+
+    // Appends up to max_count elements to values. Waits up to timeout
+    // for the first one; a zero timeout doesn't wait.
+    size_t PopBatch(std::vector<SharedPtr<T> >& values, size_t max_count, const Time& timeout)
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        if (0 == m_queue.size() && timeout > Time())
+        {
+            try 
+            {
+                ++m_waitingReaders;
+                TimedWait(timeout);
+                --m_waitingReaders;
+            } 
+            catch (...) 
+            {
+                --m_waitingReaders;
+                throw;
+            }
+        }
+
+        size_t popped = 0;
+        while (popped < max_count && 0 != m_queue.size())
+        {
+            values.push_back(SharedPtr<T>());
+            values.back().Swap(m_queue.front());
+            m_queue.pop_front();
+            ++popped;
+        }
+        return popped;
+    }
+
     bool Empty()
     {
         Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
         return 0 == m_queue.size();
     }
 
+    template<typename Function>
+    void for_each(Function fun)
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        for (typename std::list<SharedPtr<T> >::iterator iter = m_queue.begin(); iter != m_queue.end(); ++iter)
+        {
+            fun(**iter);
+        }
+    }
+
+    size_t Erase(const T& value)        // Erase all the elements equal to value
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        size_t erased = 0;
+        typename std::list<SharedPtr<T> >::iterator iter = m_queue.begin();
+        while (iter != m_queue.end())
+        {
+            if (**iter == value)
+            {
+                iter = m_queue.erase(iter);
+                ++erased;
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+        return erased;
+    }
+
+    size_t Erase(const SharedPtr<T>& value)        // Erase all the references to value
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        size_t erased = 0;
+        typename std::list<SharedPtr<T> >::iterator iter = m_queue.begin();
+        while (iter != m_queue.end())
+        {
+            if (iter->Get() == value.Get())
+            {
+                iter = m_queue.erase(iter);
+                ++erased;
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+        return erased;
+    }
 
 private:
     std::list<SharedPtr<T> > m_queue;
     short m_waitingReaders;
 };
 
-#else
-
+//
+// Two-lock queue (M. Michael and M. Scott). The list always ends with a
+// dummy node: Push fills the dummy and appends a new one under the tail
+// mutex only, Pop unlinks the head under the head mutex and takes the tail
+// mutex just long enough to compare head and tail. Nodes are allocated and
+// freed outside of the locks.
+//
+// A waiting reader announces itself in m_waitingReaders before it checks
+// for data, so Push only touches the head mutex and the condition when
+// somebody may be asleep.
+//
 template<class T> 
-class ThreadSafeQueue : public noncopyable
+class ThreadSafeQueue<T, TwoLockQueuePolicy> : public noncopyable
 {
-    
 public:
+    typedef T value_type;
+
     ThreadSafeQueue() : 
         m_head(new Node), 
-        m_tail(m_head.Get()),
+        m_tail(m_head),
         m_waitingReaders(0)
     {
     }
 
+    ~ThreadSafeQueue();
+
     SharedPtr<T> TryPop();
     bool TryPop(T& value);
     SharedPtr<T> Pop();        // Wait And Pop
@@ -238,291 +378,402 @@ public:
     bool TimedPop(T& value, const Time& timeout);       // Timed Wait And Pop
     void Push(const T& new_value);
     void Push(const SharedPtr<T>& new_value);
+    bool TryPush(const SharedPtr<T>& new_value);        // Never full: always pushes.
+    template<typename InputIterator>
+    void PushBatch(InputIterator first, InputIterator last);
+    size_t PopBatch(std::vector<SharedPtr<T> >& values, size_t max_count, const Time& timeout);
     bool Empty();
     template<typename Function>
     void for_each(Function fun);
-    size_t Erase(const T& new_value);
-    size_t Erase(const SharedPtr<T>& new_value);
+    size_t Erase(const T& value);
+    size_t Erase(const SharedPtr<T>& value);
 
 private:
     struct Node
     {
-        Threading::Mutex   m_mutex;
+        Node() : m_next(0) {}
+
         SharedPtr<T>       m_data;
-        UniquePtr<Node>    m_next;
+        Node*              m_next;
     };
-    
+
+    struct ValueEquals
+    {
+        explicit ValueEquals(const T& value) : m_value(value) {}
+        bool operator()(const SharedPtr<T>& data) const { return *data == m_value; }
+        const T& m_value;
+    };
+
+    struct PointerEquals
+    {
+        explicit PointerEquals(const SharedPtr<T>& value) : m_value(value) {}
+        bool operator()(const SharedPtr<T>& data) const { return data.Get() == m_value.Get(); }
+        const SharedPtr<T>& m_value;
+    };
+
     Node* getTail();
-    UniquePtr<Node> popHead();
-    UniquePtr<Node> tryPopHead();
-    UniquePtr<Node> tryPopHead(T& value);
-    UniquePtr<Node> waitPopHead();
-    UniquePtr<Node> waitPopHead(T& value);
-    UniquePtr<Node> timedWaitPopHead(const Time& timeout);
-    UniquePtr<Node> timedWaitPopHead(T& value, const Time& timeout);
+    Node* popHead();
+    Node* tryPopHead();
+    Node* waitPopHead(const Time* timeout);
+    void pushData(const SharedPtr<T>& new_data);
+    template<typename Predicate>
+    size_t eraseIf(Predicate pred);
 
     Threading::Mutex m_headmutex;
-    UniquePtr<Node> m_head;
+    Node* m_head;
+    Threading::Mutex m_tailmutex;
     Node* m_tail;
     Cond m_datacond;
 
-    short m_waitingReaders;
+    AtomicInt m_waitingReaders;     // Read by Push without the head mutex.
 };
 
 template<typename T>
-typename ThreadSafeQueue<T>::Node* ThreadSafeQueue<T>::getTail()
+ThreadSafeQueue<T, TwoLockQueuePolicy>::~ThreadSafeQueue()
 {
-    Threading::Mutex::LockGuard tailLock(m_tail->m_mutex);
+    while (m_head)
+    {
+        Node* const next = m_head->m_next;
+        delete m_head;
+        m_head = next;
+    }
+}
+
+template<typename T>
+typename ThreadSafeQueue<T, TwoLockQueuePolicy>::Node* ThreadSafeQueue<T, TwoLockQueuePolicy>::getTail()
+{
+    Threading::Mutex::LockGuard tailLock(m_tailmutex);
     return m_tail;
 }
 
+// The head mutex must be held and the queue must not be empty.
 template<typename T>
-UniquePtr<typename ThreadSafeQueue<T>::Node> ThreadSafeQueue<T>::popHead()
+typename ThreadSafeQueue<T, TwoLockQueuePolicy>::Node* ThreadSafeQueue<T, TwoLockQueuePolicy>::popHead()
 {
-    UniquePtr<Node> oldHead = m_head;
+    Node* const oldHead = m_head;
     m_head = oldHead->m_next; 
     return oldHead;
 }
 
 template<typename T>
-UniquePtr<typename ThreadSafeQueue<T>::Node> ThreadSafeQueue<T>::tryPopHead()
+typename ThreadSafeQueue<T, TwoLockQueuePolicy>::Node* ThreadSafeQueue<T, TwoLockQueuePolicy>::tryPopHead()
 {
     Threading::Mutex::LockGuard headLock(m_headmutex);
-    if (m_head.Get() == getTail())
+    if (m_head == getTail())
     {
-        return UniquePtr<Node>();
+        return 0;
     }
     return popHead();
 }
 
 template<typename T>
-UniquePtr<typename ThreadSafeQueue<T>::Node> ThreadSafeQueue<T>::tryPopHead(T& value)
+typename ThreadSafeQueue<T, TwoLockQueuePolicy>::Node* ThreadSafeQueue<T, TwoLockQueuePolicy>::waitPopHead(const Time* timeout)
 {
-    Threading::Mutex::LockGuard headLock(m_headmutex);
-    if (m_head.Get() == getTail())
+    Time deadline;
+    if (timeout)
     {
-        return UniquePtr<Node>();
+        deadline = Time::Now(Time::Monotonic) + *timeout;
     }
 
-    value = *m_head->m_data;
-    return popHead();
-}
-
-template<typename T>
-UniquePtr<typename ThreadSafeQueue<T>::Node> ThreadSafeQueue<T>::waitPopHead()
-{
-     Threading::Mutex::LockGuard headLock(m_headmutex);
-     while (m_head.Get() == getTail())
-     {
-        try 
-        {
-            ++m_waitingReaders;
-            m_datacond.Wait(headLock);
-            --m_waitingReaders;
-        } 
-        catch (...) 
-        {
-            --m_waitingReaders;
-            throw;
-        }
-     }
-    return popHead();
-}
-
-template<typename T>
-UniquePtr<typename ThreadSafeQueue<T>::Node> ThreadSafeQueue<T>::waitPopHead(T& value)
-{
     Threading::Mutex::LockGuard headLock(m_headmutex);
-    while (m_head.Get() == getTail())
+    ++m_waitingReaders;
+    try 
     {
-        try 
-        {
-            ++m_waitingReaders;
-            m_datacond.Wait(headLock);
-            --m_waitingReaders;
-        } 
-        catch (...) 
+        while (m_head == getTail())
         {
-            --m_waitingReaders;
-            throw;
+            if (!timeout)
+            {
+                m_datacond.Wait(headLock);
+                continue;
+            }
+
+            Time remaining = deadline - Time::Now(Time::Monotonic);
+            if (remaining <= Time() || 
+                (!m_datacond.TimedWait(headLock, remaining) && m_head == getTail())) 
+            {
+                // time out
+                --m_waitingReaders;
+                return 0;
+            }
         }
+    } 
+    catch (...) 
+    {
+        --m_waitingReaders;
+        throw;
     }
-    value = *m_head->m_data;
+    --m_waitingReaders;
+
     return popHead();
 }
 
 template<typename T>
-UniquePtr<typename ThreadSafeQueue<T>::Node> ThreadSafeQueue<T>::timedWaitPopHead(const Time& timeout)
+void ThreadSafeQueue<T, TwoLockQueuePolicy>::pushData(const SharedPtr<T>& new_data)
 {
-    Threading::Mutex::LockGuard headLock(m_headmutex);
-    while (m_head.Get() == getTail())
+    Node* const p = new Node;
     {
-        try 
-        {
-            ++m_waitingReaders;
-            if (!m_datacond.TimedWait(headLock, timeout)) 
-            {
-                // time out
-                --m_waitingReaders;
-                return UniquePtr<Node>();
-            }
-            --m_waitingReaders;
-        } 
-        catch (...) 
-        {
-            --m_waitingReaders;
-            throw;
-        }
+        Threading::Mutex::LockGuard tailLock(m_tailmutex);
+        m_tail->m_data = new_data;
+        m_tail->m_next = p;
+        m_tail = p;
     }
 
-    if (m_head.Get() == getTail())
+    //
+    // A reader increments m_waitingReaders under the head mutex before it
+    // looks at the tail, so either it sees the new node or we see it
+    // waiting. Taking the head mutex makes sure it is inside Wait().
+    //
+    if (m_waitingReaders)
     {
-        return UniquePtr<Node>();
+        Threading::Mutex::LockGuard headLock(m_headmutex);
+        m_datacond.Signal();
     }
-
-    return popHead();
 }
 
 template<typename T>
-UniquePtr<typename ThreadSafeQueue<T>::Node> ThreadSafeQueue<T>::timedWaitPopHead(T& value, const Time& timeout)
+SharedPtr<T> ThreadSafeQueue<T, TwoLockQueuePolicy>::TryPop()
 {
-    Threading::Mutex::LockGuard headLock(m_headmutex);
-    while (m_head.Get() == getTail())
+    Node* const oldHead = tryPopHead();
+    if (!oldHead)
     {
-        try 
-        {
-            ++m_waitingReaders;
-            if (!m_datacond.TimedWait(headLock, timeout)) 
-            {
-                // time out
-                --m_waitingReaders;
-                return UniquePtr<Node>();
-            }
-            --m_waitingReaders;
-        } 
-        catch (...) 
-        {
-            --m_waitingReaders;
-            throw;
-        }
+        return SharedPtr<T>();
     }
 
-    if (m_head.Get() == getTail())
+    SharedPtr<T> result;
+    result.Swap(oldHead->m_data);
+    delete oldHead;
+    return result;
+}
+
+template<typename T>
+bool ThreadSafeQueue<T, TwoLockQueuePolicy>::TryPop(T& value)
+{
+    SharedPtr<T> result = TryPop();
+    if (!result)
     {
-        return UniquePtr<Node>();
+        return false;
     }
 
-    value = *m_head->m_data;
-    return popHead();
+    value = *result;
+    return true;
 }
 
 template<typename T>
-SharedPtr<T> ThreadSafeQueue<T>::TryPop()
+SharedPtr<T> ThreadSafeQueue<T, TwoLockQueuePolicy>::Pop()
 {
-    const UniquePtr<Node> oldHead(tryPopHead());
-    return oldHead ? oldHead->m_data : SharedPtr<T>();
+    Node* const oldHead = waitPopHead(0);
+    SharedPtr<T> result;
+    result.Swap(oldHead->m_data);
+    delete oldHead;
+    return result;
 }
 
 template<typename T>
-bool ThreadSafeQueue<T>::TryPop(T& value)
+void ThreadSafeQueue<T, TwoLockQueuePolicy>::Pop(T& value)
 {
-    const UniquePtr<Node> oldHead(tryPopHead(value));
-    return oldHead;
+    value = *Pop();
+}
+
+template<typename T>
+SharedPtr<T> ThreadSafeQueue<T, TwoLockQueuePolicy>::TimedPop(const Time& timeout)            // Timed Wait And Pop
+{
+    Node* const oldHead = waitPopHead(&timeout);
+    if (!oldHead)
+    {
+        return SharedPtr<T>();
+    }
+
+    SharedPtr<T> result;
+    result.Swap(oldHead->m_data);
+    delete oldHead;
+    return result;
 }
 
 template<typename T>
-SharedPtr<T> ThreadSafeQueue<T>::Pop()
+bool ThreadSafeQueue<T, TwoLockQueuePolicy>::TimedPop(T& value, const Time& timeout)        // Timed Wait And Pop
 {
-    const UniquePtr<Node> oldHead(waitPopHead());
-    return oldHead->m_data;
+    SharedPtr<T> result = TimedPop(timeout);
+    if (!result)
+    {
+        return false;
+    }
+
+    value = *result;
+    return true;
 }
 
 template<typename T>
-void ThreadSafeQueue<T>::Pop(T& value)
+void ThreadSafeQueue<T, TwoLockQueuePolicy>::Push(const T& new_value)
 {
-    const UniquePtr<Node> oldHead(waitPopHead(value));
+    pushData(SharedPtr<T>(new T(new_value)));
 }
 
 template<typename T>
-SharedPtr<T> ThreadSafeQueue<T>::TimedPop(const Time& timeout)            // Timed Wait And Pop
+void ThreadSafeQueue<T, TwoLockQueuePolicy>::Push(const SharedPtr<T>& new_value)
 {
-    const UniquePtr<Node> oldHead(timedWaitPopHead(timeout));
-    return oldHead ? oldHead->m_data : SharedPtr<T>();
+    pushData(new_value);
 }
 
 template<typename T>
-bool ThreadSafeQueue<T>::TimedPop(T& value, const Time& timeout)        // Timed Wait And Pop
+bool ThreadSafeQueue<T, TwoLockQueuePolicy>::TryPush(const SharedPtr<T>& new_value)
 {
-    return timedWaitPopHead(value, timeout);
+    pushData(new_value);
+    return true;
 }
 
 template<typename T>
-void ThreadSafeQueue<T>::Push(const T& new_value)
+template<typename InputIterator>
+void ThreadSafeQueue<T, TwoLockQueuePolicy>::PushBatch(InputIterator first, InputIterator last)
 {
-    SharedPtr<T> newData(new T(new_value));
-    UniquePtr<Node> p(new Node);
+    if (first == last)
     {
-        Threading::Mutex::LockGuard tailLock(m_tail->m_mutex);
-        m_tail->m_data = newData;
-        Node* const new_tail = p.Get();
-        m_tail->m_next = p;
-        m_tail = new_tail;
+        return;
     }
 
+    // Build the chain outside of the lock; its last node becomes the new dummy.
+    Node* const chain = new Node;
+    chain->m_data = *first;
+    Node* chainTail = chain;
+    size_t pushed = 1;
+    for (++first; first != last; ++first, ++pushed)
+    {
+        chainTail->m_next = new Node;
+        chainTail = chainTail->m_next;
+        chainTail->m_data = *first;
+    }
+    chainTail->m_next = new Node;
+
+    {
+        Threading::Mutex::LockGuard tailLock(m_tailmutex);
+        m_tail->m_data.Swap(chain->m_data);
+        m_tail->m_next = chain->m_next;
+        m_tail = chainTail->m_next;
+    }
+    delete chain;
+
     if (m_waitingReaders)
     {
-        m_datacond.Signal();
+        Threading::Mutex::LockGuard headLock(m_headmutex);
+        if (pushed > 1)
+        {
+            m_datacond.Broadcast();
+        }
+        else
+        {
+            m_datacond.Signal();
+        }
     }
 }
 
 template<typename T>
-void ThreadSafeQueue<T>::Push(const SharedPtr<T>& new_value)
+size_t ThreadSafeQueue<T, TwoLockQueuePolicy>::PopBatch(std::vector<SharedPtr<T> >& values, size_t max_count, const Time& timeout)
 {
-    UniquePtr<Node> p(new Node);
+    if (0 == max_count)
     {
-        Threading::Mutex::LockGuard tailLock(m_tail->m_mutex);
-        m_tail->m_data = new_value;
-        Node* const new_tail = p.Get();
-        m_tail->m_next = p;
-        m_tail = new_tail;
+        return 0;
     }
 
-    if (m_waitingReaders)
+    Node* first = timeout > Time() ? waitPopHead(&timeout) : tryPopHead();
+    if (!first)
     {
-        m_datacond.Signal();
+        return 0;
+    }
+
+    Node* last = first;
+    size_t popped = 1;
+    {
+        Threading::Mutex::LockGuard headLock(m_headmutex);
+        Node* const tail = getTail();
+        while (popped < max_count && m_head != tail)
+        {
+            last->m_next = popHead();
+            last = last->m_next;
+            ++popped;
+        }
+    }
+    last->m_next = 0;
+
+    while (first)
+    {
+        Node* const next = first->m_next;
+        values.push_back(SharedPtr<T>());
+        values.back().Swap(first->m_data);
+        delete first;
+        first = next;
     }
+    return popped;
 }
 
 template<typename T>
-bool ThreadSafeQueue<T>::Empty()
+bool ThreadSafeQueue<T, TwoLockQueuePolicy>::Empty()
 {
     Threading::Mutex::LockGuard headLock(m_headmutex);
-    return (m_head.Get() == getTail());
+    return (m_head == getTail());
 }
 
+// Holds both mutexes (head first, as Pop does) while fun is applied.
 template<typename T>
 template<typename Function>
-void ThreadSafeQueue<T>::for_each(Function fun)
+void ThreadSafeQueue<T, TwoLockQueuePolicy>::for_each(Function fun)
 {
-    Threading::Mutex* sync = &m_headmutex;
-    sync->Lock();
+    Threading::Mutex::LockGuard headLock(m_headmutex);
+    Threading::Mutex::LockGuard tailLock(m_tailmutex);
 
-    Node* current = m_head.Get();
-    while (current != getTail())
+    for (Node* current = m_head; current != m_tail; current = current->m_next)
     {
         fun(*current->m_data);
-        Node* const next = current->m_next.Get();
-        Threading::Mutex* next_sync = &next->m_mutex;
-        next_sync->Lock();
-        sync->Unlock();
-        current = next;
-        sync = next_sync;
     }
+}
 
-    sync->Unlock();
+template<typename T>
+size_t ThreadSafeQueue<T, TwoLockQueuePolicy>::Erase(const T& value)
+{
+    return eraseIf(ValueEquals(value));
 }
 
-#endif
+template<typename T>
+size_t ThreadSafeQueue<T, TwoLockQueuePolicy>::Erase(const SharedPtr<T>& value)
+{
+    return eraseIf(PointerEquals(value));
+}
+
+template<typename T>
+template<typename Predicate>
+size_t ThreadSafeQueue<T, TwoLockQueuePolicy>::eraseIf(Predicate pred)
+{
+    size_t erased = 0;
+    Node* garbage = 0;
+    {
+        Threading::Mutex::LockGuard headLock(m_headmutex);
+        Threading::Mutex::LockGuard tailLock(m_tailmutex);
+
+        // The dummy tail node is never unlinked, so every erased node has a successor.
+        Node** link = &m_head;
+        while (*link != m_tail)
+        {
+            Node* const current = *link;
+            if (pred(current->m_data))
+            {
+                *link = current->m_next;
+                current->m_next = garbage;
+                garbage = current;
+                ++erased;
+            }
+            else
+            {
+                link = &current->m_next;
+            }
+        }
+    }
+
+    while (garbage)
+    {
+        Node* const next = garbage->m_next;
+        delete garbage;
+        garbage = next;
+    }
+    return erased;
+}
 
 THREADING_END
 
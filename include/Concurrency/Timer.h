@@ -13,6 +13,7 @@
 #include <map>
 #include <Util/Time.h>
 #include <Util/Shared.h>
+#include <Util/UniquePtr.h>
 #include <Concurrency/Thread.h>
 #include <Concurrency/Monitor.h>
 
@@ -46,38 +47,97 @@ struct ScheduleTask
     TimerTaskPtr    m_task;    
     Time            m_scheduledtime;  
     Time            m_delay;
+    bool            m_fixedrate;
 
     inline ScheduleTask();
 
-    inline ScheduleTask(const TimerTaskPtr& task, const Time& scheduledtime, const Time& delay = Time());
+    inline ScheduleTask(const TimerTaskPtr& task, const Time& scheduledtime, const Time& delay = Time(), bool fixedrate = false);
 
     inline bool operator <(const ScheduleTask& rhs) const;
 };
 
+//
+// Schedule of a Timer, see Timer.cpp.
+//
+class TimerQueue;
+
+class ThreadPool;
+typedef Threading::SharedPtr<ThreadPool> ThreadPoolPtr;
 
+class TimerDispatchTask;
+
+//
+// The default Timer keeps its tasks sorted, which costs O(log n) per
+// Schedule and Cancel. A Timer built with a tick uses a hierarchical
+// timing wheel instead: Schedule and Cancel are O(1), at the price of
+// rounding every expiry up to the next multiple of the tick.
+//
+// Expired tasks are run by the timer thread, one after the other, unless
+// the Timer is given a ThreadPool: the timer thread then only keeps the
+// schedule and hands expired tasks over to the pool's workers.
+//
 class THREADING_API Timer : virtual public Shared, virtual private Thread
 {
+    friend class TimerDispatchTask;
 public:
 
     Timer();
 
     Timer(int priority);
 
+    explicit Timer(const Time& tick);
+
+    Timer(const Time& tick, int priority);
+
+    // A zero tick selects the sorted schedule.
+    Timer(const ThreadPoolPtr& pool, const Time& tick = Time());
+
     virtual ~Timer();
 
     void Destroy();
 
+    //
+    // Lets expiries be late by up to slack (rounded up to a multiple of
+    // it), so that those falling within the same window are run in one
+    // wake-up of the timer thread. No slack by default.
+    //
+    void SetSlack(const Time& slack);
+
     void Schedule(const TimerTaskPtr& task, const Time& delaytime);
 
     void ScheduleRepeated(const TimerTaskPtr& task, const Time& delaytime, const Time& basetime = Time::Now(Time::Monotonic));
 
+    //
+    // Runs task at basetime + n * period instead of period after the end
+    // of its previous run, so that it does not drift. Periods missed
+    // because a run took too long are skipped, not caught up with.
+    //
+    void ScheduleAtFixedRate(const TimerTaskPtr& task, const Time& period, const Time& basetime = Time::Now(Time::Monotonic));
+
+    //
+    // Moves the next expiry of a scheduled task to delaytime from now, a
+    // repeated task keeping its period. Returns false if task is not
+    // scheduled.
+    //
+    bool Reschedule(const TimerTaskPtr& task, const Time& delaytime);
+
     bool Cancel(const TimerTaskPtr& task);
 
 private:
 
     virtual void Run();
 
-    bool doSchedule(ScheduleTask& scheduleTask);
+    bool doSchedule(std::vector<ScheduleTask>& expired);
+
+    void dispatch(const std::vector<ScheduleTask>& expired);
+
+    void runTask(const ScheduleTask& scheduleTask);
+
+    void insert(const ScheduleTask& scheduleTask);
+
+    void wakeUp(const Time& scheduledtime);
+
+    Time coalesce(const Time& time) const;
 
     bool m_destroyed;
 
@@ -85,20 +145,28 @@ private:
 
     Monitor<Threading::Mutex>    m_monitor;
 
-    std::set<ScheduleTask>    m_scheduleTasks;
+    UniquePtr<TimerQueue>    m_queue;
+
+    //
+    // Repeated tasks being run, with their next expiry if rescheduled
+    // meanwhile. A task cancelled meanwhile is removed.
+    //
+    std::map<TimerTaskPtr, Time, TimerTaskCompare>    m_running;
+
+    ThreadPoolPtr    m_pool;
 
-    std::map<TimerTaskPtr, Time, TimerTaskCompare> m_alltasks;
+    Time    m_slack;
 };
 typedef Threading::SharedPtr<Timer> TimerPtr;
 
 inline ScheduleTask::ScheduleTask() :
-    m_task(0), m_scheduledtime(Time()), m_delay(Time())
+    m_task(0), m_scheduledtime(Time()), m_delay(Time()), m_fixedrate(false)
 {
 
 }
 
-inline ScheduleTask::ScheduleTask(const TimerTaskPtr& task, const Time& scheduledtime, const Time& delay) :
-    m_task(task), m_scheduledtime(scheduledtime), m_delay(delay)
+inline ScheduleTask::ScheduleTask(const TimerTaskPtr& task, const Time& scheduledtime, const Time& delay, bool fixedrate) :
+    m_task(task), m_scheduledtime(scheduledtime), m_delay(delay), m_fixedrate(fixedrate)
 {
 }
 
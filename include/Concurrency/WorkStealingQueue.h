@@ -0,0 +1,92 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef CONCURRENCY_WORK_STEALING_QUEUE_H
+#define CONCURRENCY_WORK_STEALING_QUEUE_H
+
+#include <deque>
+#include <Concurrency/Mutex.h>
+#include <Util/SharedPtr.h>
+
+THREADING_BEGIN
+
+//
+// Per-worker task deque used by the work-stealing scheduler of ThreadPool.
+//
+// The owning worker pushes and pops at the back (LIFO, so recently
+// submitted work is still warm in its cache), while idle workers steal
+// from the front (FIFO, so they take the oldest and usually biggest
+// pieces of work). Every deque has its own mutex, so the owner only
+// contends with a thief that happens to pick the same victim; thieves
+// never block on a busy victim, they just move on to the next one.
+//
+template<class T>
+class WorkStealingQueue : public noncopyable
+{
+public:
+    WorkStealingQueue() {}
+
+    void Push(const SharedPtr<T>& new_value)
+    {
+        Threading::Mutex::LockGuard lock(m_mutex);
+        m_deque.push_back(new_value);
+    }
+
+    template<typename InputIterator>
+    void PushBatch(InputIterator first, InputIterator last)
+    {
+        Threading::Mutex::LockGuard lock(m_mutex);
+        m_deque.insert(m_deque.end(), first, last);
+    }
+
+    SharedPtr<T> TryPop()           // owner side, LIFO
+    {
+        Threading::Mutex::LockGuard lock(m_mutex);
+        if (m_deque.empty())
+        {
+            return SharedPtr<T>();
+        }
+        SharedPtr<T> result;
+        result.Swap(m_deque.back());
+        m_deque.pop_back();
+        return result;
+    }
+
+    SharedPtr<T> TrySteal()         // thief side, FIFO
+    {
+        Threading::Mutex::TryLockGuard lock(m_mutex);
+        if (!lock.Acquired() || m_deque.empty())
+        {
+            return SharedPtr<T>();
+        }
+        SharedPtr<T> result;
+        result.Swap(m_deque.front());
+        m_deque.pop_front();
+        return result;
+    }
+
+    bool Empty() const
+    {
+        Threading::Mutex::LockGuard lock(m_mutex);
+        return m_deque.empty();
+    }
+
+    size_t Size() const
+    {
+        Threading::Mutex::LockGuard lock(m_mutex);
+        return m_deque.size();
+    }
+
+private:
+    std::deque<SharedPtr<T> > m_deque;
+    Threading::Mutex m_mutex;
+};
+
+THREADING_END
+
+#endif
@@ -0,0 +1,144 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef UTIL_ASYNC_LOG_WRITER_H
+#define UTIL_ASYNC_LOG_WRITER_H
+
+#include <Config.h>
+#include <Util/Shared.h>
+#include <Util/SharedPtr.h>
+#include <Util/Time.h>
+#include <Util/Atomic.h>
+#include <Concurrency/Thread.h>
+#include <Concurrency/Monitor.h>
+#include <Concurrency/RingQueue.h>
+#include <Logging/LogSink.h>
+
+THREADING_BEGIN
+
+//
+// Sink appending log lines to a file from a background thread.
+//
+// A producer formats its line into a buffer of its own, taken from a pool
+// of recycled buffers, and pushes it onto a lock-free RingQueue; it never
+// touches the file nor takes a lock shared with the other producers. The
+// writer thread drains the queue into one staging buffer and issues a
+// single write() once BatchSize bytes are pending or the oldest pending
+// line has waited for the flush interval.
+//
+// When the queue is full, the overflow policy decides: OverflowBlock
+// waits for room, OverflowDrop discards the line, OverflowCount discards
+// it too but has the writer log how many lines were lost.
+//
+// The file is rotated by the writer thread, between two batches, so that
+// producers never wait for the files to be renamed and reopened.
+//
+// Flush() queues a marker behind the lines queued so far and waits for
+// the writer thread to reach it.
+//
+// Once Destroy() is called, the writer thread drains the queue, including
+// the lines of the producers already on their way to it, and exits; the
+// lines written after that are written by their producer, one at a time.
+//
+class THREADING_API AsyncLogWriter : public LogSink, virtual private Thread
+{
+public:
+
+    enum OverflowPolicy
+    {
+        OverflowBlock,
+        OverflowDrop,
+        OverflowCount
+    };
+
+    enum
+    {
+        BatchSize = 64 * 1024
+    };
+
+    AsyncLogWriter(const std::string& file, const Time& flushinterval = Time::MilliSeconds(200),
+                   size_t capacity = 8192, OverflowPolicy policy = OverflowBlock,
+                   const LogRotation& rotation = LogRotation());
+
+    virtual ~AsyncLogWriter();
+
+    // Writes what is queued and stops the writer thread.
+    void Destroy();
+
+    // Queues line, followed by a newline.
+    virtual void Write(const std::string& line, Color color = 0);
+
+    // Waits until the lines queued so far are written.
+    virtual void Flush();
+
+    const std::string& File() const
+    {
+        return m_file;
+    }
+
+    // Lines discarded so far because the queue was full.
+    size_t Dropped() const;
+
+private:
+
+    class LogBuffer : public Shared
+    {
+    public:
+        LogBuffer() :
+            m_marker(false),
+            m_passed(false)
+        {
+        }
+
+        std::string m_data;
+        bool m_marker;          // Queued by Flush(), not a line.
+        bool m_passed;          // The lines ahead of the marker are written, m_monitor.
+    };
+    typedef SharedPtr<LogBuffer> LogBufferPtr;
+
+    virtual void Run();
+
+    bool open();
+
+    // Rotates the file if writing bytes more to it is due to.
+    void rotate(size_t bytes);
+
+    void writeAll(const std::string& data);
+
+    // Writes data once the writer thread stopped.
+    void writeDirect(const std::string& data);
+
+    LogBufferPtr allocBuffer();
+
+    void recycleBuffer(const LogBufferPtr& buffer);
+
+    const std::string m_file;
+    const Time m_flushinterval;
+    const OverflowPolicy m_policy;
+    const LogRotation m_rotation;
+    int m_fd;
+    Int64 m_size;               // Size of the file, writer thread only, then m_monitor.
+    Time m_opened;              // When the file was opened, writer thread only, then m_monitor.
+
+    RingQueue<LogBuffer> m_queue;
+    RingQueue<LogBuffer> m_freebuffers;
+
+    AtomicInt m_dropped;        // Dropped lines not reported yet, OverflowCount.
+    AtomicInt m_totaldropped;
+    AtomicBool m_closing;       // Destroy() was called, producers write directly.
+    AtomicInt m_producers;      // Producers that may still queue a line.
+
+    Monitor<Mutex> m_monitor;   // Guards the fields below, Flush() waits on it.
+    bool m_destroyed;
+    bool m_stopped;             // The writer thread is done with the file.
+};
+typedef SharedPtr<AsyncLogWriter> AsyncLogWriterPtr;
+
+THREADING_END
+
+#endif
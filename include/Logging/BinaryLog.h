@@ -0,0 +1,224 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef UTIL_BINARY_LOG_H
+#define UTIL_BINARY_LOG_H
+
+#include <vector>
+#include <Config.h>
+#include <Util/Shared.h>
+#include <Util/SharedPtr.h>
+#include <Util/Time.h>
+#include <Util/FileUtil.h>
+#include <Concurrency/Mutex.h>
+#include <Logging/Logger.h>
+
+THREADING_BEGIN
+
+namespace internal
+{
+class BinaryLogFinisher;
+}
+
+//
+// Binary logging.
+//
+// A UTIL_BLOG statement does not format its message: it records the id of
+// its call site and its raw arguments, and the text is only rendered when
+// the file is decoded (see BinaryLogReader and the LogDecoder tool):
+//
+//   UTIL_BLOG(INFO, "task {} done in {} ms") << id << elapsed;
+//
+// Each "{}" of the format is replaced by the next argument, the arguments
+// left over are appended. The call site, i.e. its level, file, line and
+// format, is written once per batch of records written to the file, the
+// first time the site logs in the batch.
+//
+// Without a binary log (see SetBinaryLog and Logger::SetBinaryLog), the
+// message is formatted and logged as text.
+//
+
+// Static description of a UTIL_BLOG statement.
+struct BinaryLogSite
+{
+    LogSeverity m_level;
+    const char* m_file;
+    int m_line;
+    const char* m_format;
+    volatile int m_id;          // 0 until the site first logs.
+};
+
+//
+// Append-only binary log file. Records are buffered and written once
+// BufferSize bytes are pending, on errors and on Flush(). Each batch goes
+// out in one write() on a descriptor opened with O_APPEND and can be
+// decoded on its own, so that several processes may append to the same
+// file at once.
+//
+class THREADING_API BinaryLogWriter : public Shared
+{
+public:
+
+    enum
+    {
+        BufferSize = 64 * 1024
+    };
+
+    explicit BinaryLogWriter(const std::string& file);
+
+    ~BinaryLogWriter();
+
+    // Records a message of site, with its encoded arguments.
+    void Write(BinaryLogSite& site, const Time& time, const std::string& args);
+
+    void Flush();
+
+    const std::string& File() const
+    {
+        return m_file;
+    }
+
+private:
+
+    void flush();
+
+    const std::string m_file;
+    int m_fd;
+    Threading::Mutex m_mutex;
+    std::string m_buffer;
+    std::vector<bool> m_sites;  // Sites already described in m_buffer, by id.
+};
+typedef SharedPtr<BinaryLogWriter> BinaryLogWriterPtr;
+
+// The binary log of the UTIL_BLOG statements, none by default.
+THREADING_API void SetBinaryLog(const BinaryLogWriterPtr& writer);
+THREADING_API BinaryLogWriterPtr GetBinaryLog();
+
+// Renders format with the encoded arguments args.
+THREADING_API std::string FormatBinaryLog(const std::string& format, const std::string& args);
+
+//
+// A message being recorded by UTIL_BLOG, or by UTIL_BLOG_TO with logger.
+// It goes to the binary log of logger, or of the process without logger.
+//
+class THREADING_API BinaryLogRecord
+{
+public:
+
+    BinaryLogRecord(BinaryLogSite& site, const LoggerPtr& logger = LoggerPtr());
+
+    BinaryLogRecord& operator<<(const std::string& value);
+    BinaryLogRecord& operator<<(const char* value);
+    BinaryLogRecord& operator<<(char value);
+    BinaryLogRecord& operator<<(int value);
+    BinaryLogRecord& operator<<(uint value);
+    BinaryLogRecord& operator<<(long value);
+    BinaryLogRecord& operator<<(unsigned long value);
+    BinaryLogRecord& operator<<(double value);
+
+private:
+
+    friend class internal::BinaryLogFinisher;
+    void Finish() const;
+
+    BinaryLogSite& m_site;
+    LoggerPtr m_logger;
+    std::string m_args;
+};
+
+//
+// A message read back from a binary log.
+//
+struct BinaryLogEntry
+{
+    LogSeverity m_level;
+    std::string m_file;
+    int m_line;
+    Time m_time;
+    std::string m_text;
+};
+
+class THREADING_API BinaryLogReader : private noncopyable
+{
+public:
+
+    explicit BinaryLogReader(std::istream& in);
+
+    //
+    // Reads the next message, returns false at the end of the input.
+    // Throws IllegalArgumentException if the input is not a binary log.
+    //
+    bool Next(BinaryLogEntry& entry);
+
+private:
+
+    struct Site
+    {
+        bool m_defined;
+        LogSeverity m_level;
+        std::string m_file;
+        int m_line;
+        std::string m_format;
+    };
+
+    void readHeader();
+
+    void read(void* data, size_t size);
+
+    template<typename T>
+    T read()
+    {
+        T value;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    std::string readString();
+
+    std::istream& m_in;
+    bool m_header;              // A header was read.
+    std::vector<Site> m_sites;  // Sites of the current batch, by id.
+};
+
+namespace internal
+{
+
+// Gives the "cond ? (void)0 : finisher = record << ..." of UTIL_BLOG a
+// void type on both sides.
+class THREADING_API BinaryLogFinisher
+{
+public:
+    void operator=(const BinaryLogRecord& record);
+};
+
+}  // namespace internal
+
+#define UTIL_BLOG_SITE UTIL_LOG_SITE_NAME(utilBinaryLogSite)
+
+//
+// Both macros declare the site of the statement, so that they cannot be
+// the only statement of an unbraced if or loop.
+//
+#define UTIL_BLOG(LEVEL, FORMAT)                                            \
+    static ::Threading::BinaryLogSite UTIL_BLOG_SITE =                      \
+        { ::Threading::LOGLEVEL_##LEVEL, __FILE__, __LINE__, FORMAT, 0 };   \
+    !UTIL_LOG_IS_ON(LEVEL) ? (void)0 :                                      \
+    ::Threading::internal::BinaryLogFinisher() =                            \
+    ::Threading::BinaryLogRecord(UTIL_BLOG_SITE)
+
+#define UTIL_BLOG_TO(LOGGER, LEVEL, FORMAT)                                 \
+    static ::Threading::BinaryLogSite UTIL_BLOG_SITE =                      \
+        { ::Threading::LOGLEVEL_##LEVEL, __FILE__, __LINE__, FORMAT, 0 };   \
+    !(UTIL_LOG_IS_ON(LEVEL) &&                                              \
+      (LOGGER)->IsEnabled(::Threading::LOGLEVEL_##LEVEL)) ? (void)0 :       \
+    ::Threading::internal::BinaryLogFinisher() =                            \
+    ::Threading::BinaryLogRecord(UTIL_BLOG_SITE, (LOGGER))
+
+THREADING_END
+
+#endif
@@ -0,0 +1,87 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef UTIL_LOG_RATE_LIMIT_H
+#define UTIL_LOG_RATE_LIMIT_H
+
+#include <Config.h>
+#include <Logging/Logger.h>
+
+THREADING_BEGIN
+
+//
+// State of a sampled or rate-limited log statement. A POD: static sites
+// are zero-initialized and ready to use, other sites must be value-
+// initialized, e.g. m_site() in a constructor's initializer list.
+//
+struct LogSite
+{
+    int m_count;            // Occurrences, modulo n for LogEveryN, up to n for LogFirstN.
+    bool m_seen;            // An occurrence was seen, LogEveryT and LogRateLimited.
+    int m_suppressed;       // Occurrences dropped since the last logged one.
+    int m_report;           // Dropped occurrences the next message reports.
+    Int64 m_last;           // Last logged or refilled, in microseconds on the monotonic clock.
+    double m_tokens;
+};
+
+//
+// The admission functions tell whether an occurrence of site is logged.
+// They are thread-safe.
+//
+
+// The 1st, (n + 1)th, (2n + 1)th... occurrences.
+THREADING_API bool LogEveryN(LogSite& site, int n);
+
+// The first n occurrences.
+THREADING_API bool LogFirstN(LogSite& site, int n);
+
+// The first occurrence, then the first one at least seconds after the last logged.
+THREADING_API bool LogEveryT(LogSite& site, double seconds);
+
+//
+// Token bucket: up to burst occurrences at once, refilled by rate per
+// second.
+//
+THREADING_API bool LogRateLimited(LogSite& site, double rate, double burst);
+
+//
+// "(N messages suppressed) " when occurrences were dropped before the
+// one just admitted by LogEveryT or LogRateLimited, else "".
+//
+THREADING_API std::string TakeSuppressed(LogSite& site);
+
+//
+// UTIL_LOG variants, each one with a site of its own:
+//
+//   UTIL_LOG_EVERY_N(WARNING, 100) << "queue full";
+//   UTIL_LOG_EVERY_T(ERROR, 10) << "cannot connect: " << reason;
+//
+// The message arguments are only evaluated when the message is logged.
+// These macros declare their site, so that they cannot be the only
+// statement of an unbraced if or loop.
+//
+#define UTIL_LOG_SAMPLED_(LEVEL, ADMIT)                                     \
+    static ::Threading::LogSite UTIL_LOG_SITE_NAME(utilLogSite);            \
+    !(UTIL_LOG_IS_ON(LEVEL) && (ADMIT)) ? (void)0 :                         \
+    UTIL_LOG_MESSAGE(LEVEL) << ::Threading::TakeSuppressed(UTIL_LOG_SITE_NAME(utilLogSite))
+
+#define UTIL_LOG_EVERY_N(LEVEL, N)                                          \
+    UTIL_LOG_SAMPLED_(LEVEL, ::Threading::LogEveryN(UTIL_LOG_SITE_NAME(utilLogSite), (N)))
+
+#define UTIL_LOG_FIRST_N(LEVEL, N)                                          \
+    UTIL_LOG_SAMPLED_(LEVEL, ::Threading::LogFirstN(UTIL_LOG_SITE_NAME(utilLogSite), (N)))
+
+#define UTIL_LOG_EVERY_T(LEVEL, SECONDS)                                    \
+    UTIL_LOG_SAMPLED_(LEVEL, ::Threading::LogEveryT(UTIL_LOG_SITE_NAME(utilLogSite), (SECONDS)))
+
+#define UTIL_LOG_RATE_LIMITED(LEVEL, RATE, BURST)                           \
+    UTIL_LOG_SAMPLED_(LEVEL, ::Threading::LogRateLimited(UTIL_LOG_SITE_NAME(utilLogSite), (RATE), (BURST)))
+
+THREADING_END
+
+#endif
@@ -0,0 +1,171 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef UTIL_LOG_SINK_H
+#define UTIL_LOG_SINK_H
+
+#include <Config.h>
+#include <Util/Shared.h>
+#include <Util/SharedPtr.h>
+#include <Util/UniquePtr.h>
+#include <Util/FileUtil.h>
+#include <Util/Time.h>
+#include <Concurrency/Mutex.h>
+
+THREADING_BEGIN
+
+class Properties;
+typedef SharedPtr<Properties> PropertiesPtr;
+
+//
+// When and how a log file is rotated: once it would grow beyond a maximum
+// size, or once it has been open for a maximum age, file is renamed to
+// file.1, file.1 to file.2 and so on, only the keep most recent files
+// being retained, and a new file is started.
+//
+// The age is counted from when the sink opened the file. A zero maximum
+// size or age disables the corresponding check.
+//
+class THREADING_API LogRotation
+{
+public:
+
+    // Never rotates.
+    LogRotation();
+
+    LogRotation(Int64 maxsize, const Time& maxage, int keep);
+
+    //
+    // Reads <prefix>.MaxSize, in kilobytes, <prefix>.MaxAge, in seconds,
+    // and <prefix>.Keep, 5 by default.
+    //
+    static LogRotation Load(const PropertiesPtr& properties, const std::string& prefix);
+
+    bool Enabled() const
+    {
+        return m_maxsize > 0 || m_maxage > Time();
+    }
+
+    //
+    // Whether a file of size bytes, opened at opened (on the monotonic
+    // clock), must be rotated before bytes more are written to it.
+    //
+    bool Due(Int64 size, const Time& opened, size_t bytes) const;
+
+    // Renames file and its retained predecessors, dropping the oldest.
+    void Rotate(const std::string& file) const;
+
+    Int64 MaxSize() const
+    {
+        return m_maxsize;
+    }
+
+    const Time& MaxAge() const
+    {
+        return m_maxage;
+    }
+
+    int Keep() const
+    {
+        return m_keep;
+    }
+
+private:
+
+    Int64 m_maxsize;
+    Time m_maxage;
+    int m_keep;
+};
+
+//
+// Destination of log lines. A sink serializes its own output, so that
+// loggers writing to different sinks never contend, and may be shared by
+// any number of loggers.
+//
+class THREADING_API LogSink : virtual public Shared
+{
+public:
+
+    typedef std::ostream& (*Color)(std::ostream&);
+
+    virtual ~LogSink() {}
+
+    // Writes line followed by a newline; color only matters to consoles.
+    virtual void Write(const std::string& line, Color color = 0) = 0;
+
+    virtual void Flush() {}
+};
+typedef SharedPtr<LogSink> LogSinkPtr;
+
+class THREADING_API FileLogSink : public LogSink
+{
+public:
+
+    //
+    // The file is rotated by a background thread, shared by all the sinks,
+    // once a line goes past the rotation limits; the writers keep
+    // appending to the renamed file until the new one is swapped in, so
+    // that file goes past the limits by what is written meanwhile. On
+    // Windows, where an open file cannot be renamed, the writers wait for
+    // the rotation.
+    //
+    explicit FileLogSink(const std::string& file, const LogRotation& rotation = LogRotation());
+
+    //
+    // The sink of file shared by all the callers, opened on first use:
+    // loggers writing to the same file then share its stream and lock.
+    // The rotation only applies when the sink is opened.
+    //
+    static LogSinkPtr Open(const std::string& file, const LogRotation& rotation = LogRotation());
+
+    virtual void Write(const std::string& line, Color color = 0);
+
+    virtual void Flush();
+
+    // Rotates the file now, on the calling thread.
+    void Rotate();
+
+    const std::string& File() const
+    {
+        return m_file;
+    }
+
+private:
+
+    // Opens the file for appending into out, returns its size.
+    Int64 open(Threading::ofstream& out) const;
+
+    const std::string m_file;
+    const LogRotation m_rotation;
+    UniquePtr<Threading::ofstream> m_out;
+    Threading::Mutex m_mutex;   // Guards the fields below.
+    Int64 m_size;               // Size of the file.
+    Time m_opened;              // When the file was opened.
+    bool m_rotating;            // A rotation is on its way.
+    Threading::Mutex m_rotatemutex;     // Serializes Rotate().
+};
+
+class THREADING_API StderrLogSink : public LogSink
+{
+public:
+
+    // The process' stderr sink.
+    static LogSinkPtr Instance();
+
+    virtual void Write(const std::string& line, Color color = 0);
+
+    virtual void Flush();
+
+private:
+
+    Threading::Mutex m_mutex;
+};
+
+THREADING_END
+
+#endif
@@ -14,6 +14,7 @@
 #include <Util/Shared.h>
 #include <Util/SharedPtr.h>
 #include <Util/FileUtil.h>
+#include <Logging/LogSink.h>
 
 
 THREADING_BEGIN
@@ -21,6 +22,42 @@ THREADING_BEGIN
 class Logger;
 typedef Threading::SharedPtr<Logger> LoggerPtr;
 
+class BinaryLogWriter;
+typedef Threading::SharedPtr<BinaryLogWriter> BinaryLogWriterPtr;
+
+enum LogSeverity 
+{
+    LOGLEVEL_INFO,     // Informational.  
+    LOGLEVEL_WARNING,  // Warns.
+    LOGLEVEL_ERROR,    // An error occurred which should never happen during
+                       // normal use.
+    LOGLEVEL_FATAL,    // An error occurred from which the library cannot
+                       // recover.  This usually indicates a programming error
+                       // in the code which calls the library, especially when
+                       // compiled in debug mode.
+
+#ifdef NDEBUG
+    LOGLEVEL_DFATAL = LOGLEVEL_ERROR
+#else
+    LOGLEVEL_DFATAL = LOGLEVEL_FATAL
+#endif
+};
+
+//
+// Messages below UTIL_MIN_LOG_LEVEL (a LogSeverity value, 0 by default)
+// are compiled out of the UTIL_LOG macros altogether. Above it, they are
+// dropped at run time below the process-wide level of SetLogLevel and,
+// for a Logger, below its own level, before any formatting. FATAL
+// messages are never dropped.
+//
+#ifndef UTIL_MIN_LOG_LEVEL
+#   define UTIL_MIN_LOG_LEVEL 0
+#endif
+
+THREADING_API void SetLogLevel(LogSeverity level);
+THREADING_API LogSeverity GetLogLevel();
+THREADING_API bool IsLogEnabled(LogSeverity level);
+
 THREADING_API LoggerPtr GetProcessLogger();
 THREADING_API void SetProcessLogger(const LoggerPtr&);
 
@@ -28,7 +65,14 @@ class THREADING_API Logger : public Shared
 {
 public:
 
-    Logger(const std::string& prefix, const std::string& file);
+    //
+    // Logs to file, through the sink shared by all the loggers of file
+    // (see FileLogSink::Open), or to stderr if file is empty.
+    //
+    Logger(const std::string& prefix, const std::string& file, const LogRotation& rotation = LogRotation());
+
+    // Logs to sink, e.g. an AsyncLogWriter.
+    Logger(const std::string& prefix, const LogSinkPtr& sink);
     ~Logger();
 
     virtual void Print(const std::string& message);
@@ -37,16 +81,46 @@ public:
     virtual void Error(const std::string& message);
     virtual LoggerPtr CloneWithPrefix(const std::string& prefix);
 
+    // Drops Trace, Warning and Error messages below level.
+    void SetLevel(LogSeverity level)
+    {
+        m_level = level;
+    }
+
+    LogSeverity GetLevel() const
+    {
+        return m_level;
+    }
+
+    bool IsEnabled(LogSeverity level) const
+    {
+        return LOGLEVEL_FATAL == level || (level >= m_level && IsLogEnabled(level));
+    }
+
+    const LogSinkPtr& Sink() const
+    {
+        return m_sink;
+    }
+
+    // Where the UTIL_BLOG_TO statements of this logger go, none by default.
+    void SetBinaryLog(const BinaryLogWriterPtr& writer);
+
+    const BinaryLogWriterPtr& BinaryLog() const
+    {
+        return m_binarylog;
+    }
+
 protected:
-    Logger(){}
+    Logger();
 
 private:
 
     void Write(const std::string& message, bool indent, std::ostream& (*color)(std::ostream &out) = 0);
 
     std::string m_prefix;
-    Threading::ofstream m_out;
-    std::string m_file;
+    LogSinkPtr m_sink;
+    volatile LogSeverity m_level;
+    BinaryLogWriterPtr m_binarylog;
 };
 
 //
@@ -63,24 +137,6 @@ THREADING_API ::std::string FormatFileLocation(const char* file, int line);
 //   LogToStderr()  - directs all log messages to stderr.
 //   FlushInfoLog() - flushes informational log messages.
 
-enum LogSeverity 
-{
-    LOGLEVEL_INFO,     // Informational.  
-    LOGLEVEL_WARNING,  // Warns.
-    LOGLEVEL_ERROR,    // An error occurred which should never happen during
-                       // normal use.
-    LOGLEVEL_FATAL,    // An error occurred from which the library cannot
-                       // recover.  This usually indicates a programming error
-                       // in the code which calls the library, especially when
-                       // compiled in debug mode.
-
-#ifdef NDEBUG
-    LOGLEVEL_DFATAL = LOGLEVEL_ERROR
-#else
-    LOGLEVEL_DFATAL = LOGLEVEL_FATAL
-#endif
-};
-
 // Formats log entry severity, provides a stream object for streaming the
 // log message, and terminates the message with a newline when going out of
 // scope.
@@ -111,8 +167,10 @@ operator <<(StderrLog& out, const T& val)
     return out;
 }
 
-#define STDERR_LOG(severity) \
-    ::Threading::StderrLog(::Threading::##severity, __FILE__, __LINE__).GetStream()
+#define STDERR_LOG(severity)                                          \
+    !::Threading::IsLogEnabled(::Threading::severity) ? (void)0 :     \
+    ::Threading::internal::LogVoidify() &                             \
+    ::Threading::StderrLog(::Threading::severity, __FILE__, __LINE__).GetStream()
 
 //inline void LogToStderr() {}
 inline void FlushInfoLog()
@@ -156,6 +214,13 @@ namespace internal
 {
 class LogFinisher;
 
+// Gives "cond ? (void)0 : stream << ..." a void type on both sides.
+class LogVoidify
+{
+public:
+    void operator &(::std::ostream&) {}
+};
+
 class THREADING_API LogMessage
 {
 public:
@@ -200,6 +265,11 @@ public:
 // end up using our definitions instead.
 #undef UTIL_LOG
 #undef UTIL_LOG_IF
+#undef UTIL_LOG_IS_ON
+#undef UTIL_LOG_MESSAGE
+#undef UTIL_LOG_CONCAT_
+#undef UTIL_LOG_CONCAT
+#undef UTIL_LOG_SITE_NAME
 
 #undef UTIL_CHECK
 #undef UTIL_CHECK_EQ
@@ -219,12 +289,27 @@ public:
 #undef UTIL_DCHECK_GT
 #undef UTIL_DCHECK_GE
 
-#define UTIL_LOG(LEVEL)                               \
+//
+// The message arguments are only evaluated when the message is logged.
+//
+#define UTIL_LOG_IS_ON(LEVEL)                                          \
+    ((::Threading::LOGLEVEL_##LEVEL >= UTIL_MIN_LOG_LEVEL ||           \
+      ::Threading::LOGLEVEL_##LEVEL == ::Threading::LOGLEVEL_FATAL) && \
+     ::Threading::IsLogEnabled(::Threading::LOGLEVEL_##LEVEL))
+
+#define UTIL_LOG_MESSAGE(LEVEL)                       \
     ::Threading::internal::LogFinisher() =                 \
     ::Threading::internal::LogMessage(                     \
     ::Threading::LOGLEVEL_##LEVEL, __FILE__, __LINE__)
+#define UTIL_LOG(LEVEL)                               \
+    !UTIL_LOG_IS_ON(LEVEL) ? (void)0 : UTIL_LOG_MESSAGE(LEVEL)
 #define UTIL_LOG_IF(LEVEL, CONDITION)                 \
-    !(CONDITION) ? (void)0 : UTIL_LOG(LEVEL)
+    !(UTIL_LOG_IS_ON(LEVEL) && (CONDITION)) ? (void)0 : UTIL_LOG_MESSAGE(LEVEL)
+
+// Names the static state a logging macro declares for its call site.
+#define UTIL_LOG_CONCAT_(A, B) A##B
+#define UTIL_LOG_CONCAT(A, B) UTIL_LOG_CONCAT_(A, B)
+#define UTIL_LOG_SITE_NAME(PREFIX) UTIL_LOG_CONCAT(PREFIX, __LINE__)
 
 #define UTIL_CHECK(EXPRESSION)                        \
     UTIL_LOG_IF(FATAL, !(EXPRESSION)) << "CHECK failed: " #EXPRESSION ": "
@@ -13,16 +13,28 @@
 
 THREADING_BEGIN
 
+//
+// A disabled output (see Logger::IsEnabled) ignores what is streamed into
+// it, so that nothing gets formatted.
+//
 class THREADING_API LoggerOutputBase : private Threading::noncopyable
 {
 public:
 
+    LoggerOutputBase(bool enabled = true);
+
+    bool Enabled() const
+    {
+        return m_enabled;
+    }
+
     std::string Str() const;
    
     std::ostringstream& Strstream(); // For internal use only. Don't use in your code.
     
 private:
 
+    const bool m_enabled;
     std::ostringstream m_strstream;
 };
 
@@ -30,7 +42,10 @@ template<typename T>
 inline LoggerOutputBase&
 operator <<(LoggerOutputBase& out, const T& val)
 {
-    out.Strstream() << val;
+    if (out.Enabled())
+    {
+        out.Strstream() << val;
+    }
     return out;
 }
 
@@ -38,11 +53,12 @@ THREADING_API LoggerOutputBase& operator <<(LoggerOutputBase&, std::ios_base& (*
 THREADING_API LoggerOutputBase& operator <<(LoggerOutputBase&, std::ostream& (*)(std::ostream&));        // for std::endl like io function
 THREADING_API LoggerOutputBase& operator <<(LoggerOutputBase&, const ::std::exception& ex);
 
-template<class L, class LPtr, void (L::*output)(const std::string&)>
+template<class L, class LPtr, void (L::*output)(const std::string&), LogSeverity level>
 class LoggerOutput : public LoggerOutputBase
 {
 public:
     inline LoggerOutput(const LPtr& lptr) :
+        LoggerOutputBase(lptr->IsEnabled(level)),
         m_logger(lptr)
     {}
     
@@ -67,9 +83,10 @@ private:
     LPtr m_logger;
 };
 
-typedef LoggerOutput<Logger, LoggerPtr, &Logger::Print> Print;
-typedef LoggerOutput<Logger, LoggerPtr, &Logger::Warning> Warning;
-typedef LoggerOutput<Logger, LoggerPtr, &Logger::Error> Error;
+// Print is never filtered.
+typedef LoggerOutput<Logger, LoggerPtr, &Logger::Print, LOGLEVEL_FATAL> Print;
+typedef LoggerOutput<Logger, LoggerPtr, &Logger::Warning, LOGLEVEL_WARNING> Warning;
+typedef LoggerOutput<Logger, LoggerPtr, &Logger::Error, LOGLEVEL_ERROR> Error;
 
 class THREADING_API Trace : public LoggerOutputBase
 {
@@ -0,0 +1,54 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef UTIL_TIMESTAMP_CACHE_H
+#define UTIL_TIMESTAMP_CACHE_H
+
+#include <Config.h>
+#include <Util/Time.h>
+
+THREADING_BEGIN
+
+//
+// Formats times the way Time::ToDateTime() does, remembering the date and
+// time of the last second formatted: while the second does not change,
+// only the milliseconds are rewritten, without localtime() or strftime().
+//
+// A cache is not synchronized, each thread must use its own; see
+// AppendLogTimestamp() for the per-thread caches the loggers use.
+//
+class THREADING_API TimestampCache
+{
+public:
+
+    TimestampCache();
+
+    // Appends time.ToDateTime() to out.
+    void Append(std::string& out, const Time& time);
+
+private:
+
+    enum
+    {
+        MaxLength = 32
+    };
+
+    Int64 m_second;             // Second the prefix was formatted for, -1 for none.
+    char m_prefix[MaxLength];   // Date and time up to the '.' included.
+    size_t m_length;
+};
+
+//
+// Appends Time::Now().ToDateTime() to out, through the calling thread's
+// cache.
+//
+THREADING_API void AppendLogTimestamp(std::string& out);
+
+THREADING_END
+
+#endif
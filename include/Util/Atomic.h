@@ -12,127 +12,608 @@
 #include <Config.h>
 #ifdef LANG_CPP11
 #    include <atomic>
+#endif
+
+//
+// Atomic operations on integers and pointers, backed by the compiler:
+// the __atomic builtins of GCC >= 4.7 and Clang, the older __sync builtins
+// of GCC, or the Interlocked functions of MSVC. Other compilers fall back
+// to the striped spin mutexes of GetSpinMutex().
+//
+#if defined(__ATOMIC_ACQUIRE)
+#    define UTIL_ATOMIC_BUILTIN
+#elif defined(__GNUC__)
+#    define UTIL_ATOMIC_SYNC
+#elif defined(_MSC_VER)
+#    include <intrin.h>
+#    define UTIL_ATOMIC_INTERLOCKED
 #else
-#    include <Concurrency/Mutex.h>
+#    include <Concurrency/SpinMutex.h>
+#    define UTIL_ATOMIC_MUTEX
+#endif
 
 THREADING_BEGIN
 
-class THREADING_API AtomicBool : public Threading::Mutex
+//
+// Same meaning as the std::memory_order of C++11. An order that does not
+// apply to an operation (e.g. release for a load) is strengthened to the
+// nearest one that does.
+//
+enum MemoryOrder
+{
+    MemoryOrderRelaxed,
+    MemoryOrderConsume,
+    MemoryOrderAcquire,
+    MemoryOrderRelease,
+    MemoryOrderAcqRel,
+    MemoryOrderSeqCst
+};
+
+namespace internal
+{
+
+#if defined(UTIL_ATOMIC_BUILTIN)
+
+inline int loadOrder(MemoryOrder order)
+{
+    switch (order)
+    {
+    case MemoryOrderRelaxed:    return __ATOMIC_RELAXED;
+    case MemoryOrderConsume:    return __ATOMIC_CONSUME;
+    case MemoryOrderAcquire:
+    case MemoryOrderRelease:
+    case MemoryOrderAcqRel:     return __ATOMIC_ACQUIRE;
+    default:                    return __ATOMIC_SEQ_CST;
+    }
+}
+
+inline int storeOrder(MemoryOrder order)
+{
+    switch (order)
+    {
+    case MemoryOrderRelaxed:    return __ATOMIC_RELAXED;
+    case MemoryOrderConsume:
+    case MemoryOrderAcquire:
+    case MemoryOrderRelease:
+    case MemoryOrderAcqRel:     return __ATOMIC_RELEASE;
+    default:                    return __ATOMIC_SEQ_CST;
+    }
+}
+
+inline int rmwOrder(MemoryOrder order)
+{
+    switch (order)
+    {
+    case MemoryOrderRelaxed:    return __ATOMIC_RELAXED;
+    case MemoryOrderConsume:    return __ATOMIC_CONSUME;
+    case MemoryOrderAcquire:    return __ATOMIC_ACQUIRE;
+    case MemoryOrderRelease:    return __ATOMIC_RELEASE;
+    case MemoryOrderAcqRel:     return __ATOMIC_ACQ_REL;
+    default:                    return __ATOMIC_SEQ_CST;
+    }
+}
+
+#elif defined(UTIL_ATOMIC_INTERLOCKED)
+
+//
+// The Interlocked functions by operand size, the operands are punned to
+// and from LONG or LONGLONG.
+//
+template<size_t Size>
+struct Interlocked;
+
+template<>
+struct Interlocked<4>
+{
+    typedef LONG Word;
+
+    static Word CompareExchange(volatile Word* p, Word desired, Word expected)
+    {
+        return InterlockedCompareExchange(p, desired, expected);
+    }
+
+    static Word Exchange(volatile Word* p, Word value)
+    {
+        return InterlockedExchange(p, value);
+    }
+
+    static Word ExchangeAdd(volatile Word* p, Word delta)
+    {
+        return InterlockedExchangeAdd(p, delta);
+    }
+};
+
+template<>
+struct Interlocked<8>
+{
+    typedef LONGLONG Word;
+
+    static Word CompareExchange(volatile Word* p, Word desired, Word expected)
+    {
+        return InterlockedCompareExchange64(p, desired, expected);
+    }
+
+    static Word Exchange(volatile Word* p, Word value)
+    {
+        return InterlockedExchange64(p, value);
+    }
+
+    static Word ExchangeAdd(volatile Word* p, Word delta)
+    {
+        return InterlockedExchangeAdd64(p, delta);
+    }
+};
+
+template<typename T>
+union InterlockedWord
+{
+    T m_value;
+    typename Interlocked<sizeof(T)>::Word m_word;
+};
+
+template<typename T>
+typename Interlocked<sizeof(T)>::Word toWord(T value)
+{
+    InterlockedWord<T> u;
+    u.m_word = 0;
+    u.m_value = value;
+    return u.m_word;
+}
+
+template<typename T>
+T fromWord(typename Interlocked<sizeof(T)>::Word word)
+{
+    InterlockedWord<T> u;
+    u.m_word = word;
+    return u.m_value;
+}
+
+template<typename T>
+volatile typename Interlocked<sizeof(T)>::Word* wordPtr(volatile T* p)
+{
+    return reinterpret_cast<volatile typename Interlocked<sizeof(T)>::Word*>(p);
+}
+
+#elif defined(UTIL_ATOMIC_MUTEX)
+
+class AtomicLock
 {
 public:
-    AtomicBool(bool value = false) : m_value(value)
+
+    explicit AtomicLock(const volatile void* p) :
+        m_mutex(GetSpinMutex(const_cast<const void*>(p)))
     {
+        m_mutex.Lock();
     }
 
-    bool operator =(bool value)
+    ~AtomicLock()
     {
-        Threading::Mutex::LockGuard sync(*this);
-        m_value = value;
-        return m_value;
+        m_mutex.Unlock();
     }
 
-    operator bool() const
+private:
+
+    SpinMutex& m_mutex;
+};
+
+#endif
+
+}  // namespace internal
+
+//
+// The operations below apply to integers and pointers of 4 or 8 bytes
+// accessed through a volatile lvalue. They are what Atomic<T>, AtomicPtr<T>
+// and AtomicBool are made of, and serve fields that cannot be wrapped, e.g.
+// the elements of a std::vector.
+//
+
+template<typename T>
+inline T AtomicLoad(const volatile T* p, MemoryOrder order = MemoryOrderSeqCst)
+{
+#if defined(UTIL_ATOMIC_BUILTIN)
+    return __atomic_load_n(p, internal::loadOrder(order));
+#elif defined(UTIL_ATOMIC_SYNC)
+    if (MemoryOrderSeqCst == order)
+    {
+        __sync_synchronize();
+    }
+    T value = *p;
+    if (MemoryOrderRelaxed != order)
+    {
+        __sync_synchronize();
+    }
+    return value;
+#elif defined(UTIL_ATOMIC_INTERLOCKED)
+    if (MemoryOrderSeqCst == order)
     {
-        Threading::Mutex::LockGuard sync(*this);
-        return m_value;
+        return internal::fromWord<T>(internal::Interlocked<sizeof(T)>::CompareExchange(
+            internal::wordPtr(const_cast<volatile T*>(p)), 0, 0));
+    }
+    T value = *p;
+    _ReadWriteBarrier();
+    return value;
+#else
+    internal::AtomicLock lock(p);
+    return *p;
+#endif
+}
+
+template<typename T>
+inline void AtomicStore(volatile T* p, T value, MemoryOrder order = MemoryOrderSeqCst)
+{
+#if defined(UTIL_ATOMIC_BUILTIN)
+    __atomic_store_n(p, value, internal::storeOrder(order));
+#elif defined(UTIL_ATOMIC_SYNC)
+    if (MemoryOrderRelaxed != order)
+    {
+        __sync_synchronize();
+    }
+    *p = value;
+    if (MemoryOrderSeqCst == order)
+    {
+        __sync_synchronize();
+    }
+#elif defined(UTIL_ATOMIC_INTERLOCKED)
+    if (MemoryOrderSeqCst == order)
+    {
+        internal::Interlocked<sizeof(T)>::Exchange(internal::wordPtr(p), internal::toWord(value));
+        return;
+    }
+    _ReadWriteBarrier();
+    *p = value;
+#else
+    internal::AtomicLock lock(p);
+    *p = value;
+#endif
+}
+
+template<typename T>
+inline T AtomicExchange(volatile T* p, T value, MemoryOrder order = MemoryOrderSeqCst)
+{
+#if defined(UTIL_ATOMIC_BUILTIN)
+    return __atomic_exchange_n(p, value, internal::rmwOrder(order));
+#elif defined(UTIL_ATOMIC_SYNC)
+    (void)order;
+    T expected = *p;
+    T previous;
+    while ((previous = __sync_val_compare_and_swap(p, expected, value)) != expected)
+    {
+        expected = previous;
+    }
+    return previous;
+#elif defined(UTIL_ATOMIC_INTERLOCKED)
+    (void)order;
+    return internal::fromWord<T>(internal::Interlocked<sizeof(T)>::Exchange(
+        internal::wordPtr(p), internal::toWord(value)));
+#else
+    (void)order;
+    internal::AtomicLock lock(p);
+    T previous = *p;
+    *p = value;
+    return previous;
+#endif
+}
+
+//
+// Strong compare-and-swap: stores desired if *p equals expected and returns
+// true, otherwise loads *p into expected and returns false.
+//
+template<typename T>
+inline bool AtomicCompareExchange(volatile T* p, T& expected, T desired, MemoryOrder order = MemoryOrderSeqCst)
+{
+#if defined(UTIL_ATOMIC_BUILTIN)
+    return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                       internal::rmwOrder(order), internal::loadOrder(order));
+#elif defined(UTIL_ATOMIC_SYNC)
+    (void)order;
+    T previous = __sync_val_compare_and_swap(p, expected, desired);
+    if (previous == expected)
+    {
+        return true;
+    }
+    expected = previous;
+    return false;
+#elif defined(UTIL_ATOMIC_INTERLOCKED)
+    (void)order;
+    T previous = internal::fromWord<T>(internal::Interlocked<sizeof(T)>::CompareExchange(
+        internal::wordPtr(p), internal::toWord(desired), internal::toWord(expected)));
+    if (previous == expected)
+    {
+        return true;
+    }
+    expected = previous;
+    return false;
+#else
+    (void)order;
+    internal::AtomicLock lock(p);
+    if (*p == expected)
+    {
+        *p = desired;
+        return true;
+    }
+    expected = *p;
+    return false;
+#endif
+}
+
+// Adds delta to the integer *p and returns its previous value.
+template<typename T>
+inline T AtomicFetchAdd(volatile T* p, T delta, MemoryOrder order = MemoryOrderSeqCst)
+{
+#if defined(UTIL_ATOMIC_BUILTIN)
+    return __atomic_fetch_add(p, delta, internal::rmwOrder(order));
+#elif defined(UTIL_ATOMIC_SYNC)
+    (void)order;
+    return __sync_fetch_and_add(p, delta);
+#elif defined(UTIL_ATOMIC_INTERLOCKED)
+    (void)order;
+    return internal::fromWord<T>(internal::Interlocked<sizeof(T)>::ExchangeAdd(
+        internal::wordPtr(p), internal::toWord(delta)));
+#else
+    (void)order;
+    internal::AtomicLock lock(p);
+    T previous = *p;
+    *p = previous + delta;
+    return previous;
+#endif
+}
+
+template<typename T>
+inline T AtomicFetchSub(volatile T* p, T delta, MemoryOrder order = MemoryOrderSeqCst)
+{
+    return AtomicFetchAdd(p, static_cast<T>(T() - delta), order);
+}
+
+inline void AtomicThreadFence(MemoryOrder order = MemoryOrderSeqCst)
+{
+#if defined(UTIL_ATOMIC_BUILTIN)
+    __atomic_thread_fence(internal::rmwOrder(order));
+#elif defined(UTIL_ATOMIC_SYNC)
+    if (MemoryOrderRelaxed != order)
+    {
+        __sync_synchronize();
+    }
+#elif defined(UTIL_ATOMIC_INTERLOCKED)
+    if (MemoryOrderSeqCst == order)
+    {
+        MemoryBarrier();
+    }
+    else
+    {
+        _ReadWriteBarrier();
+    }
+#else
+    //
+    // The fallback has no fence of its own, taking and releasing any of
+    // the striped mutexes orders the accesses around it.
+    //
+    if (MemoryOrderRelaxed != order)
+    {
+        static volatile int fence = 0;
+        internal::AtomicLock lock(&fence);
+    }
+#endif
+}
+
+//
+// Atomic integer. The plain operators are sequentially consistent, the
+// named operations take an explicit memory order.
+//
+template<typename T>
+class Atomic : private noncopyable
+{
+public:
+
+    Atomic(T value = T()) : m_value(value)
+    {
+    }
+
+    T Load(MemoryOrder order = MemoryOrderSeqCst) const
+    {
+        return AtomicLoad(&m_value, order);
+    }
+
+    void Store(T value, MemoryOrder order = MemoryOrderSeqCst)
+    {
+        AtomicStore(&m_value, value, order);
+    }
+
+    T Exchange(T value, MemoryOrder order = MemoryOrderSeqCst)
+    {
+        return AtomicExchange(&m_value, value, order);
+    }
+
+    bool CompareExchange(T& expected, T desired, MemoryOrder order = MemoryOrderSeqCst)
+    {
+        return AtomicCompareExchange(&m_value, expected, desired, order);
+    }
+
+    T FetchAdd(T delta, MemoryOrder order = MemoryOrderSeqCst)
+    {
+        return AtomicFetchAdd(&m_value, delta, order);
+    }
+
+    T FetchSub(T delta, MemoryOrder order = MemoryOrderSeqCst)
+    {
+        return AtomicFetchSub(&m_value, delta, order);
+    }
+
+    T operator =(T value)
+    {
+        Store(value);
+        return value;
+    }
+
+    operator T() const
+    {
+        return Load();
+    }
+
+    T operator ++()
+    {
+        return FetchAdd(1) + 1;
+    }
+
+    T operator --()
+    {
+        return FetchSub(1) - 1;
+    }
+
+    T operator ++(int)
+    {
+        return FetchAdd(1);
+    }
+
+    T operator --(int)
+    {
+        return FetchSub(1);
+    }
+
+    T operator +=(T rhs)
+    {
+        return FetchAdd(rhs) + rhs;
+    }
+
+    T operator -=(T rhs)
+    {
+        return FetchSub(rhs) - rhs;
+    }
+
+    T operator *=(T rhs)
+    {
+        T value = Load(MemoryOrderRelaxed);
+        while (!CompareExchange(value, value * rhs))
+        {
+        }
+        return value * rhs;
+    }
+
+    T operator /=(T rhs)
+    {
+        T value = Load(MemoryOrderRelaxed);
+        while (!CompareExchange(value, value / rhs))
+        {
+        }
+        return value / rhs;
+    }
+
+    T operator %=(T rhs)
+    {
+        T value = Load(MemoryOrderRelaxed);
+        while (!CompareExchange(value, value % rhs))
+        {
+        }
+        return value % rhs;
     }
 
 private:
-    volatile bool m_value;
+
+    volatile T m_value;
 };
 
-class THREADING_API AtomicInt : public Threading::Mutex
+typedef Atomic<int> AtomicInt;
+typedef Atomic<Int64> AtomicInt64;
+
+//
+// Atomic pointer, without arithmetic.
+//
+template<typename T>
+class AtomicPtr : private noncopyable
 {
 public:
-    AtomicInt(int value = 0) : m_value(value)
+
+    AtomicPtr(T* value = 0) : m_value(value)
+    {
+    }
+
+    T* Load(MemoryOrder order = MemoryOrderSeqCst) const
+    {
+        return AtomicLoad(&m_value, order);
+    }
+
+    void Store(T* value, MemoryOrder order = MemoryOrderSeqCst)
+    {
+        AtomicStore(&m_value, value, order);
+    }
+
+    T* Exchange(T* value, MemoryOrder order = MemoryOrderSeqCst)
     {
+        return AtomicExchange(&m_value, value, order);
     }
 
-    int operator =(int value)
+    bool CompareExchange(T*& expected, T* desired, MemoryOrder order = MemoryOrderSeqCst)
     {
-        Threading::Mutex::LockGuard sync(*this);
-        m_value = value;
-        return m_value;
+        return AtomicCompareExchange(&m_value, expected, desired, order);
     }
 
-    int operator ++()        
+    T* operator =(T* value)
     {
-        Threading::Mutex::LockGuard sync(*this);
-        ++m_value;
-        return m_value;
+        Store(value);
+        return value;
     }
 
-    int operator --()            
+    operator T*() const
     {
-        Threading::Mutex::LockGuard sync(*this);
-        --m_value;
-        return m_value;
+        return Load();
     }
 
-    int operator ++(int)        
+    T* operator ->() const
     {
-        Threading::Mutex::LockGuard sync(*this);
-        int ret = m_value;
-        ++m_value;
-        return ret;
+        return Load();
     }
 
-    int operator --(int)
+private:
+
+    T* volatile m_value;
+};
+
+class AtomicBool : private noncopyable
+{
+public:
+
+    AtomicBool(bool value = false) : m_value(value ? 1 : 0)
     {
-        Threading::Mutex::LockGuard sync(*this);
-        int ret = m_value;
-        --m_value;
-        return ret;
     }
 
-    int operator +=(int rhs)
+    bool Load(MemoryOrder order = MemoryOrderSeqCst) const
     {
-        Threading::Mutex::LockGuard syncl(*this);
-        m_value += rhs;
-        return m_value;
+        return 0 != AtomicLoad(&m_value, order);
     }
 
-    int operator -=(int rhs)
+    void Store(bool value, MemoryOrder order = MemoryOrderSeqCst)
     {
-        Threading::Mutex::LockGuard syncl(*this);
-        m_value -= rhs;
-        return m_value;
+        AtomicStore(&m_value, value ? 1 : 0, order);
     }
-    
-    int operator *=(int rhs)
+
+    bool Exchange(bool value, MemoryOrder order = MemoryOrderSeqCst)
     {
-        Threading::Mutex::LockGuard syncl(*this);
-        m_value *= rhs;
-        return *this;
+        return 0 != AtomicExchange(&m_value, value ? 1 : 0, order);
     }
 
-    int operator /=(int rhs)
+    bool CompareExchange(bool& expected, bool desired, MemoryOrder order = MemoryOrderSeqCst)
     {
-        Threading::Mutex::LockGuard syncl(*this);
-        m_value /= rhs;
-        return m_value;
+        int previous = expected ? 1 : 0;
+        bool exchanged = AtomicCompareExchange(&m_value, previous, desired ? 1 : 0, order);
+        expected = 0 != previous;
+        return exchanged;
     }
 
-    int operator %=(int rhs)
+    bool operator =(bool value)
     {
-        Threading::Mutex::LockGuard syncl(*this);
-        m_value %= rhs;
-        return m_value;
+        Store(value);
+        return value;
     }
 
-    operator int() const
+    operator bool() const
     {
-        Threading::Mutex::LockGuard sync(*this);
-        return m_value;
+        return Load();
     }
 
 private:
+
     volatile int m_value;
 };
 
 THREADING_END
 
 #endif
-
-
-#endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef UTIL_ATOMIC_SHARED_PTR_H
+#define UTIL_ATOMIC_SHARED_PTR_H
+
+#include <Config.h>
+#include <Util/Atomic.h>
+#include <Util/SharedPtr.h>
+#include <Concurrency/Mutex.h>
+#include <Concurrency/ThreadControl.h>
+
+THREADING_BEGIN
+
+//
+// A SharedPtr<T> that threads load and replace concurrently, e.g. the
+// current configuration or logger, for T derived from Shared.
+//
+// Load() takes no lock and does not wait: it announces itself in one of
+// two reader counters, takes a reference on the current object and leaves.
+// The writers are serialized by a mutex; a writer that replaces an object
+// releases its reference only once the readers that may have seen it are
+// gone, flipping the counter new readers use so that it cannot starve.
+// The reference a reader takes is what keeps the object alive after that.
+//
+// Writers are expected to be rare, readers frequent.
+//
+template<typename T>
+class AtomicSharedPtr : private noncopyable
+{
+public:
+
+    AtomicSharedPtr(const SharedPtr<T>& value = SharedPtr<T>()) :
+        m_ptr(value.Get()),
+        m_version(0)
+    {
+        if (m_ptr)
+        {
+            m_ptr->IncRef();
+        }
+        m_readers[0] = 0;
+        m_readers[1] = 0;
+    }
+
+    ~AtomicSharedPtr()
+    {
+        if (m_ptr)
+        {
+            m_ptr->DecRef();
+        }
+    }
+
+    SharedPtr<T> Load() const
+    {
+        volatile int& readers = m_readers[AtomicLoad(&m_version) & 1];
+        AtomicFetchAdd(&readers, 1);
+        SharedPtr<T> value = AtomicLoad(&m_ptr);
+        AtomicFetchSub(&readers, 1, MemoryOrderRelease);
+        return value;
+    }
+
+    void Store(const SharedPtr<T>& value)
+    {
+        Exchange(value);
+    }
+
+    SharedPtr<T> Exchange(const SharedPtr<T>& value)
+    {
+        Threading::Mutex::LockGuard sync(m_mutex);
+        return replace(value.Get());
+    }
+
+    //
+    // Replaces the object with desired if it is expected, compared by
+    // address, otherwise loads the current one into expected.
+    //
+    bool CompareExchange(SharedPtr<T>& expected, const SharedPtr<T>& desired)
+    {
+        Threading::Mutex::LockGuard sync(m_mutex);
+        T* current = AtomicLoad(&m_ptr, MemoryOrderRelaxed);
+        if (current != expected.Get())
+        {
+            // Only writers release the current object, and we are one.
+            expected = current;
+            return false;
+        }
+        replace(desired.Get());
+        return true;
+    }
+
+    SharedPtr<T> operator =(const SharedPtr<T>& value)
+    {
+        Store(value);
+        return value;
+    }
+
+    operator SharedPtr<T>() const
+    {
+        return Load();
+    }
+
+private:
+
+    // Called with m_mutex locked, returns the object replaced.
+    SharedPtr<T> replace(T* value)
+    {
+        if (value)
+        {
+            value->IncRef();
+        }
+        T* previous = AtomicExchange(&m_ptr, value);
+        if (!previous)
+        {
+            return SharedPtr<T>();
+        }
+
+        //
+        // A reader counted before the flip may still be about to take a
+        // reference on previous; after two flips, both counters were
+        // drained at least once since previous was unpublished.
+        //
+        for (int i = 0; i < 2; ++i)
+        {
+            int version = AtomicLoad(&m_version, MemoryOrderRelaxed);
+            AtomicStore(&m_version, version + 1);
+            while (0 != AtomicLoad(&m_readers[version & 1], MemoryOrderAcquire))
+            {
+                ThreadControl::Yield();
+            }
+        }
+
+        SharedPtr<T> result = previous;
+        previous->DecRef();
+        return result;
+    }
+
+    T* volatile m_ptr;
+    volatile int m_version;
+    char m_pad0[CACHE_LINE_SIZE];
+    mutable volatile int m_readers[2];
+    char m_pad1[CACHE_LINE_SIZE];
+    Threading::Mutex m_mutex;
+};
+
+THREADING_END
+
+#endif
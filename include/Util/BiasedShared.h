@@ -0,0 +1,176 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#ifndef UTIL_BIASED_SHARED_H
+#define UTIL_BIASED_SHARED_H
+
+#include <Config.h>
+#include <Util/Atomic.h>
+#include <Util/SharedPtr.h>
+
+THREADING_BEGIN
+
+namespace internal
+{
+class BiasedOwner;
+typedef SharedPtr<BiasedOwner> BiasedOwnerPtr;
+
+#if defined(__GNUC__)
+//
+// The record of the calling thread, 0 until it creates an object, kept
+// in compiler TLS so that the owner check is a plain load.
+//
+#   define UTIL_BIASED_OWNER_TLS
+extern __thread BiasedOwner* tCurrentBiasedOwner;
+
+inline BiasedOwner* CurrentBiasedOwner()
+{
+    return tCurrentBiasedOwner;
+}
+#else
+// The record of the calling thread, 0 until it creates an object.
+THREADING_API BiasedOwner* CurrentBiasedOwner();
+#endif
+}
+
+//
+// class BiasedShared
+//
+// A thread-safe base class for reference-counted types, as Shared, for
+// the objects whose references are mostly copied by the thread that
+// created them (biased reference counting).
+//
+// The creating thread owns a count of its own, updated without atomic
+// instructions. The other threads batch their copies and releases in a
+// small cache of their own, and only add them to the shared atomic count
+// when the cache entry is evicted, on MergeQueued() or when they exit.
+// When the owner drops its last reference, it collects the cached counts
+// of all the threads and merges them with its own and the shared one: the
+// object behaves as a Shared from then on.
+//
+// A reference counted by the owner may be released by another thread,
+// e.g. after going through a queue. If that takes the shared count below
+// zero once added to it, the object is handed back to the owner, which
+// merges the counts as above and deletes the object if it was the last
+// reference: on MergeQueued(), which ThreadPool workers call before
+// parking, or when the owner thread exits, whichever comes first. A
+// thread that creates or releases such objects and outlives them for
+// long should call MergeQueued() now and then.
+//
+// Use it instead of Shared, SharedPtr<T> works with both.
+//
+class THREADING_API BiasedShared
+{
+public:
+    BiasedShared();
+    BiasedShared(const BiasedShared&);
+
+    virtual ~BiasedShared();
+
+    BiasedShared& operator =(const BiasedShared&)
+    {
+        return *this;
+    }
+
+    void IncRef()
+    {
+        if (isOwner())
+        {
+            ++m_biased;
+        }
+        else
+        {
+            defer(1);
+        }
+    }
+
+    void DecRef()
+    {
+        if (isOwner())
+        {
+            if (0 == --m_biased)
+            {
+                merge();
+            }
+        }
+        else
+        {
+            defer(-1);
+        }
+    }
+
+    //
+    // Exact once the counts are merged; before, the counts the other
+    // threads still cache are left out.
+    //
+    int GetRef() const;
+
+    void SetNoDelete(bool b)
+    {
+        m_noDelete = b;
+    }
+
+    //
+    // Merges the objects handed back to the calling thread, and adds the
+    // counts it cached to the shared counts.
+    //
+    static void MergeQueued();
+
+private:
+
+    friend class internal::BiasedOwner;
+
+    //
+    // m_shared holds the shared count times CountOne, plus the flags.
+    //
+    enum
+    {
+        QueuedFlag = 1,         // Handed back to the owner, or its counts being collected.
+        MergedFlag = 2,         // The owner count was merged.
+        CachedFlag = 4,         // Counted in the cache of some thread, until merged.
+        FlagMask = 7,
+        CountOne = 8
+    };
+
+    // What adding to the shared count leaves to do.
+    enum Outcome
+    {
+        Alive,
+        HandBack,
+        Dead
+    };
+
+    static int countOf(int shared)
+    {
+        return (shared - (shared & FlagMask)) / CountOne;
+    }
+
+    bool isOwner() const
+    {
+        return m_owner.Get() == internal::CurrentBiasedOwner() && !m_merged;
+    }
+
+    void defer(int count);
+    bool cacheable();
+    Outcome addShared(int count);
+    void settle(Outcome outcome);
+    void merge();
+    void mergeQueued();
+    void unqueue(int shared);
+    void destroy();
+
+    internal::BiasedOwnerPtr m_owner;   // 0 if there was no owner to bias to.
+    int m_biased;               // Owner thread only.
+    bool m_merged;              // Owner thread only.
+    volatile int m_shared;
+    bool m_noDelete;
+};
+
+THREADING_END
+
+#endif
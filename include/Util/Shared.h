@@ -11,34 +11,7 @@
 
 
 #include <Config.h>
-
-#if defined(USE_MUTEX_SHARED)
-
-#   include <Util/Mutex.h>
-
-// Using the gcc builtins requires gcc 4.1 or better. For Linux, i386
-// doesn't work. Apple is supported for all architectures. Sun only
-// supports sparc (32 and 64 bit).
-
-#elif (__GNUC__ >= 4 && __GNUC_MINOR__ >= 1 || __clang__)  &&            \
-        ((defined(__sun) && (defined(__sparc) || defined(__sparcv9))) || \
-         defined(__APPLE__) || \
-        (defined(__linux) && \
-                (defined(__i486) || defined(__i586) || \
-                 defined(__i686) || defined(__x86_64))))
-
-#   define HAS_GCC_BUILTINS
-
-#elif (defined(__APPLE__) || defined(__linux) || defined(__FreeBSD__)) && (defined(__i386) || defined(__x86_64)) && !defined(__ICC)
-
-#   define HAS_ATOMIC_FUNCTIONS
-
-#elif defined(_WIN32)
-// Nothing to include
-#else
-// Use a simple mutex
-#    include <Concurrency/Mutex.h>
-#endif
+#include <Util/Atomic.h>
 
 THREADING_BEGIN
 // class SimpleShared
@@ -100,6 +73,10 @@ private:
 
 // class Shared
 /// A thread-safe base class for reference-counted types.
+///
+/// The count is updated inline, without a virtual call: IncRef is a
+/// relaxed increment, DecRef an acq_rel decrement, so that the thread
+/// deleting the object sees every write made through the other references.
 class THREADING_API Shared
 {
 public:
@@ -117,21 +94,38 @@ public:
         return *this;
     }
     
-    virtual void IncRef();
-    virtual void DecRef();
-    virtual int GetRef() const;
-    virtual void SetNoDelete(bool);
+    void IncRef()
+    {
+#ifndef NDEBUG
+        int c =
+#endif
+            AtomicFetchAdd(&m_ref, 1, MemoryOrderRelaxed);
+        assert(c >= 0);
+    }
+    
+    void DecRef()
+    {
+        int c = AtomicFetchSub(&m_ref, 1, MemoryOrderAcqRel);
+        assert(c > 0);
+        if (1 == c && !m_noDelete)
+        {
+            m_noDelete = true;
+            delete this;
+        }
+    }
+    
+    int GetRef() const
+    {
+        return AtomicLoad(&m_ref, MemoryOrderAcquire);
+    }
+    
+    void SetNoDelete(bool b)
+    {
+        m_noDelete = b;
+    }
     
 protected:
-#if defined(_WIN32)
-    LONG    m_ref;        
-#elif defined(HAS_ATOMIC_FUNCTIONS) || defined(HAS_GCC_BUILTINS)
     volatile int m_ref;
-
-#else
-    long    m_ref;
-    Threading::Mutex    m_mutex;    
-#endif
     bool m_noDelete;    
 };
 
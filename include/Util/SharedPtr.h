@@ -14,6 +14,7 @@
 #endif // _MSC_VER > 1000
 
 #include <algorithm>
+#include <utility>
 #include <Util/Exception.h>
 
 THREADING_BEGIN
@@ -159,6 +160,22 @@ public:
             this->m_ptr->IncRef();
         }
     }
+
+#ifdef LANG_CPP11
+    // Moving takes the reference of rhs over, the count is not touched.
+    template<typename Y>
+    SharedPtr(SharedPtr<Y>&& rhs)
+    {
+        this->m_ptr = rhs.m_ptr;
+        rhs.m_ptr = 0;
+    }
+
+    SharedPtr(SharedPtr&& rhs)
+    {
+        this->m_ptr = rhs.m_ptr;
+        rhs.m_ptr = 0;
+    }
+#endif
     
     ~SharedPtr()
     {
@@ -184,14 +201,7 @@ public:
             
             if (ptr)
             {
-                long lRefCount = ptr->GetRef();
-                
                 ptr->DecRef();
-                
-                if (1 == lRefCount)
-                {
-                    ptr = 0;
-                }
             }
         }
         return *this;
@@ -212,14 +222,7 @@ public:
             
             if (ptr)
             {
-                long lRefCount = ptr->GetRef();
-                
                 ptr->DecRef();
-                
-                if (1 == lRefCount)
-                {
-                    ptr = 0;
-                }
             }
         }
         return *this;
@@ -239,18 +242,26 @@ public:
             
             if (ptr)
             {
-                long lRefCount = ptr->GetRef();
-                
                 ptr->DecRef();
-                
-                if (1 == lRefCount)
-                {
-                    ptr = 0;
-                }
             }
         }
         return *this;
     }
+
+#ifdef LANG_CPP11
+    template<typename Y>
+    SharedPtr& operator=(SharedPtr<Y>&& rhs)
+    {
+        SharedPtr(std::move(rhs)).Swap(*this);
+        return *this;
+    }
+
+    SharedPtr& operator=(SharedPtr&& rhs)
+    {
+        SharedPtr(std::move(rhs)).Swap(*this);
+        return *this;
+    }
+#endif
     
     template<class Y>
     static SharedPtr DynamicCast(const SharedPtrBase<Y>& rhs)
@@ -1,13 +1,17 @@
 RecMutex$(OBJEXT): RecMutex.cpp "$(includedir)/Concurrency/RecMutex.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h"
 Cond$(OBJEXT): Cond.cpp "$(includedir)/Concurrency/Cond.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Semaphore.h"
-Timer$(OBJEXT): Timer.cpp "$(includedir)/Concurrency/Timer.h" "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Shared.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/Monitor.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/Semaphore.h"
+Timer$(OBJEXT): Timer.cpp "$(includedir)/Concurrency/Timer.h" "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/UniquePtr.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/Monitor.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Concurrency/ThreadPool.h" "$(includedir)/Concurrency/Runnable.h" "$(includedir)/Concurrency/ThreadSafeQueue.h" "$(includedir)/Concurrency/RingQueue.h" "$(includedir)/Concurrency/EventCount.h" "$(includedir)/Concurrency/AbstractQueue.h" "$(includedir)/Concurrency/LaneQueue.h" "$(includedir)/Concurrency/ThreadSafeList.h" "$(includedir)/Concurrency/WorkStealingQueue.h" "$(includedir)/Concurrency/ThreadLocal.h" "$(includedir)/Util/TypeTraits.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Util/BiasedShared.h" "$(includedir)/Util/Properties.h" "$(includedir)/Logging/LoggerUtil.h" "$(includedir)/Logging/LogRateLimit.h" "$(includedir)/Concurrency/Future.h"
 Mutex$(OBJEXT): Mutex.cpp "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h"
-ThreadControl$(OBJEXT): ThreadControl.cpp "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Time.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h"
+ThreadControl$(OBJEXT): ThreadControl.cpp "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h"
 Semaphore$(OBJEXT): Semaphore.cpp "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h"
-ThreadPool$(OBJEXT): ThreadPool.cpp "$(includedir)/Concurrency/ThreadPool.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Runnable.h" "$(includedir)/Util/Shared.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/ThreadSafeQueue.h" "$(includedir)/Concurrency/Monitor.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Concurrency/ThreadSafeList.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/UniquePtr.h" "$(includedir)/Util/Properties.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LoggerUtil.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/FileUtil.h"
+ThreadPool$(OBJEXT): ThreadPool.cpp "$(includedir)/Concurrency/ThreadPool.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Runnable.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/ThreadSafeQueue.h" "$(includedir)/Concurrency/Monitor.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Concurrency/RingQueue.h" "$(includedir)/Concurrency/EventCount.h" "$(includedir)/Concurrency/AbstractQueue.h" "$(includedir)/Concurrency/LaneQueue.h" "$(includedir)/Concurrency/ThreadSafeList.h" "$(includedir)/Util/UniquePtr.h" "$(includedir)/Concurrency/WorkStealingQueue.h" "$(includedir)/Concurrency/ThreadLocal.h" "$(includedir)/Util/TypeTraits.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Concurrency/Timer.h" "$(includedir)/Util/BiasedShared.h" "$(includedir)/Util/Properties.h" "$(includedir)/Logging/LoggerUtil.h" "$(includedir)/Logging/LogRateLimit.h" "$(includedir)/Concurrency/Future.h"
 StaticMutex$(OBJEXT): StaticMutex.cpp "$(includedir)/Concurrency/StaticMutex.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h"
 RWRecMutex$(OBJEXT): RWRecMutex.cpp "$(includedir)/Concurrency/RWRecMutex.h" "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h"
-Thread$(OBJEXT): Thread.cpp "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/Shared.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Build/UndefSysMacros.h"
+Thread$(OBJEXT): Thread.cpp "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/Shared.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h"
 ThreadException$(OBJEXT): ThreadException.cpp "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h"
-SpinMutex$(OBJEXT): SpinMutex.cpp "$(includedir)/Concurrency/SpinMutex.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/StaticMutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/Shared.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Build/UndefSysMacros.h"
+SpinMutex$(OBJEXT): SpinMutex.cpp "$(includedir)/Concurrency/SpinMutex.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/StaticMutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h"
 CountdownLatch$(OBJEXT): CountdownLatch.cpp "$(includedir)/Concurrency/CountdownLatch.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h"
+EventCount$(OBJEXT): EventCount.cpp "$(includedir)/Concurrency/EventCount.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Util/Atomic.h"
+Future$(OBJEXT): Future.cpp "$(includedir)/Concurrency/Future.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/ThreadPool.h" "$(includedir)/Concurrency/Runnable.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/ThreadSafeQueue.h" "$(includedir)/Concurrency/Monitor.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Concurrency/RingQueue.h" "$(includedir)/Concurrency/EventCount.h" "$(includedir)/Concurrency/AbstractQueue.h" "$(includedir)/Concurrency/LaneQueue.h" "$(includedir)/Concurrency/ThreadSafeList.h" "$(includedir)/Util/UniquePtr.h" "$(includedir)/Concurrency/WorkStealingQueue.h" "$(includedir)/Concurrency/ThreadLocal.h" "$(includedir)/Util/TypeTraits.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Concurrency/Timer.h" "$(includedir)/Util/BiasedShared.h" "$(includedir)/Util/Properties.h" "$(includedir)/Logging/LoggerUtil.h" "$(includedir)/Logging/LogRateLimit.h"
+CpuSet$(OBJEXT): CpuSet.cpp "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Build/UndefSysMacros.h"
+MemoryReclamation$(OBJEXT): MemoryReclamation.cpp "$(includedir)/Concurrency/MemoryReclamation.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/ThreadLocal.h" "$(includedir)/Util/TypeTraits.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Concurrency/MutexPtrLock.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h"
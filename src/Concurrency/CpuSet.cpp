@@ -0,0 +1,244 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <Concurrency/CpuSet.h>
+#include <Concurrency/Thread.h>
+#include <Util/Exception.h>
+
+#if defined(__linux)
+#   include <dirent.h>
+#endif
+
+Threading::CpuSet::CpuSet()
+{
+}
+
+Threading::CpuSet::CpuSet(const std::string& cpulist)
+{
+    std::string::size_type pos = 0;
+    while (pos < cpulist.size())
+    {
+        char* end = 0;
+        const char* begin = cpulist.c_str() + pos;
+        while (isspace(static_cast<unsigned char>(*begin)))
+        {
+            ++begin;
+        }
+        if ('\0' == *begin)
+        {
+            break;
+        }
+        if (!isdigit(static_cast<unsigned char>(*begin)))
+        {
+            throw IllegalArgumentException(__FILE__, __LINE__, "invalid CPU list `" + cpulist + "'");
+        }
+
+        unsigned long first = strtoul(begin, &end, 10);
+        unsigned long last = first;
+        if ('-' == *end)
+        {
+            begin = end + 1;
+            if (!isdigit(static_cast<unsigned char>(*begin)))
+            {
+                throw IllegalArgumentException(__FILE__, __LINE__, "invalid CPU list `" + cpulist + "'");
+            }
+            last = strtoul(begin, &end, 10);
+        }
+
+        while (isspace(static_cast<unsigned char>(*end)))
+        {
+            ++end;
+        }
+        if (last < first || ('\0' != *end && ',' != *end))
+        {
+            throw IllegalArgumentException(__FILE__, __LINE__, "invalid CPU list `" + cpulist + "'");
+        }
+
+        for (unsigned long cpu = first; cpu <= last; ++cpu)
+        {
+            Set(static_cast<size_t>(cpu));
+        }
+
+        pos = static_cast<std::string::size_type>(end - cpulist.c_str());
+        if (pos < cpulist.size())
+        {
+            ++pos;      // skip ','
+        }
+    }
+}
+
+void Threading::CpuSet::Set(size_t cpu)
+{
+    if (cpu >= m_cpus.size())
+    {
+        m_cpus.resize(cpu + 1, false);
+    }
+    m_cpus[cpu] = true;
+}
+
+void Threading::CpuSet::Clear(size_t cpu)
+{
+    if (cpu < m_cpus.size())
+    {
+        m_cpus[cpu] = false;
+    }
+}
+
+bool Threading::CpuSet::IsSet(size_t cpu) const
+{
+    return cpu < m_cpus.size() && m_cpus[cpu];
+}
+
+bool Threading::CpuSet::Empty() const
+{
+    return 0 == Count();
+}
+
+size_t Threading::CpuSet::Count() const
+{
+    size_t count = 0;
+    for (size_t cpu = 0; cpu < m_cpus.size(); ++cpu)
+    {
+        if (m_cpus[cpu])
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::vector<size_t> Threading::CpuSet::Cpus() const
+{
+    std::vector<size_t> cpus;
+    for (size_t cpu = 0; cpu < m_cpus.size(); ++cpu)
+    {
+        if (m_cpus[cpu])
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::string Threading::CpuSet::ToString() const
+{
+    std::ostringstream out;
+    std::vector<size_t> cpus = Cpus();
+    for (size_t i = 0; i < cpus.size(); )
+    {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+        {
+            ++j;
+        }
+
+        if (i > 0)
+        {
+            out << ',';
+        }
+        out << cpus[i];
+        if (j > i)
+        {
+            out << '-' << cpus[j];
+        }
+        i = j + 1;
+    }
+    return out.str();
+}
+
+bool Threading::CpuSet::operator ==(const CpuSet& rhs) const
+{
+    return Cpus() == rhs.Cpus();
+}
+
+Threading::CpuSet Threading::CpuSet::Available()
+{
+    CpuSet cpus;
+#if defined(_WIN32)
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+    {
+        for (size_t cpu = 0; cpu < sizeof(DWORD_PTR) * 8; ++cpu)
+        {
+            if (processMask & (static_cast<DWORD_PTR>(1) << cpu))
+            {
+                cpus.Set(cpu);
+            }
+        }
+    }
+#elif defined(__linux)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (0 == sched_getaffinity(0, sizeof(set), &set))
+    {
+        for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.Set(cpu);
+            }
+        }
+    }
+#endif
+
+    if (cpus.Empty())
+    {
+        unsigned count = Thread::HardwareConcurrency();
+        for (size_t cpu = 0; cpu < count; ++cpu)
+        {
+            cpus.Set(cpu);
+        }
+    }
+    return cpus;
+}
+
+int Threading::CpuSet::NumaNode(size_t cpu)
+{
+#if defined(__linux)
+    std::ostringstream path;
+    path << "/sys/devices/system/cpu/cpu" << cpu;
+    DIR* dir = opendir(path.str().c_str());
+    if (0 == dir)
+    {
+        return 0;
+    }
+
+    int node = 0;
+    for (struct dirent* entry = readdir(dir); 0 != entry; entry = readdir(dir))
+    {
+        if (0 == strncmp(entry->d_name, "node", 4) && isdigit(static_cast<unsigned char>(entry->d_name[4])))
+        {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#else
+    return 0;
+#endif
+}
+
+#if defined(__linux)
+void Threading::CpuSet::Fill(cpu_set_t& set) const
+{
+    CPU_ZERO(&set);
+    for (size_t cpu = 0; cpu < m_cpus.size() && cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (m_cpus[cpu])
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+}
+#endif
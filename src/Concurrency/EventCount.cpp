@@ -0,0 +1,96 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <Concurrency/EventCount.h>
+
+Threading::EventCount::EventCount(void) :
+    m_waiters(0),
+    m_epoch(0)
+{
+}
+
+Threading::EventCount::~EventCount(void)
+{
+}
+
+Threading::EventCount::Key Threading::EventCount::PrepareWait()
+{
+    //
+    // The increment is a full barrier: a notifier that changes the
+    // condition after this point either sees us as a waiter or the
+    // re-check done by the caller sees the changed condition.
+    //
+    ++m_waiters;
+    return m_epoch;
+}
+
+void Threading::EventCount::CancelWait()
+{
+    --m_waiters;
+}
+
+void Threading::EventCount::Wait(Key key)
+{
+    {
+        Threading::Mutex::LockGuard lock(m_mutex);
+        while (key == m_epoch)
+        {
+            m_cond.Wait(lock);
+        }
+    }
+    --m_waiters;
+}
+
+bool Threading::EventCount::TimedWait(Key key, const Time& timeout)
+{
+    bool notified = true;
+    {
+        Threading::Mutex::LockGuard lock(m_mutex);
+        if (key == m_epoch)
+        {
+            notified = m_cond.TimedWait(lock, timeout) || key != m_epoch;
+        }
+    }
+    --m_waiters;
+    return notified;
+}
+
+void Threading::EventCount::Notify()
+{
+    doNotify(false);
+}
+
+void Threading::EventCount::NotifyAll()
+{
+    doNotify(true);
+}
+
+bool Threading::EventCount::HasWaiters() const
+{
+    Threading::AtomicThreadFence();
+    return 0 != m_waiters.Load(Threading::MemoryOrderRelaxed);
+}
+
+void Threading::EventCount::doNotify(bool broadcast)
+{
+    if (!HasWaiters())
+    {
+        return;
+    }
+
+    Threading::Mutex::LockGuard lock(m_mutex);
+    ++m_epoch;
+    if (broadcast)
+    {
+        m_cond.Broadcast();
+    }
+    else
+    {
+        m_cond.Signal();
+    }
+}
@@ -0,0 +1,205 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <exception>
+#include <Concurrency/Future.h>
+
+Threading::FutureStateBase::FutureStateBase() :
+    m_ready(false),
+    m_waiters(0),
+    m_promises(0)
+{
+}
+
+Threading::FutureStateBase::~FutureStateBase()
+{
+}
+
+bool Threading::FutureStateBase::IsReady() const
+{
+    Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+    return m_ready;
+}
+
+bool Threading::FutureStateBase::HasException() const
+{
+    Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+    return m_ready && m_exception;
+}
+
+void Threading::FutureStateBase::WaitReady() const
+{
+    Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+    while (!m_ready)
+    {
+        try
+        {
+            ++m_waiters;
+            Wait();
+            --m_waiters;
+        }
+        catch (...)
+        {
+            --m_waiters;
+            throw;
+        }
+    }
+}
+
+bool Threading::FutureStateBase::TimedWaitReady(const Time& timeout) const
+{
+    Time deadline = Time::Now(Time::Monotonic) + timeout;
+
+    Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+    while (!m_ready)
+    {
+        Time remaining = deadline - Time::Now(Time::Monotonic);
+        if (remaining <= Time())
+        {
+            return false;
+        }
+
+        try
+        {
+            ++m_waiters;
+            TimedWait(remaining);
+            --m_waiters;
+        }
+        catch (...)
+        {
+            --m_waiters;
+            throw;
+        }
+    }
+    return true;
+}
+
+void Threading::FutureStateBase::SetException(const Exception& ex)
+{
+    Continuations continuations;
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        checkNotReady();
+        m_exception.Reset(ex.Clone());
+        setReady(continuations);
+    }
+    runContinuations(continuations);
+}
+
+void Threading::FutureStateBase::SetCurrentException()
+{
+    try
+    {
+        throw;
+    }
+    catch (const Exception& ex)
+    {
+        SetException(ex);
+    }
+    catch (const std::exception& ex)
+    {
+        SetException(FutureException(__FILE__, __LINE__, ex.what()));
+    }
+    catch (...)
+    {
+        SetException(FutureException(__FILE__, __LINE__, "unknown exception"));
+    }
+}
+
+void Threading::FutureStateBase::AddContinuation(const TaskPtr& task, const ThreadPoolPtr& pool)
+{
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        if (!m_ready)
+        {
+            m_continuations.push_back(std::make_pair(task, pool));
+            return;
+        }
+    }
+
+    runContinuations(Continuations(1, std::make_pair(task, pool)));
+}
+
+void Threading::FutureStateBase::PromiseAttached()
+{
+    ++m_promises;
+}
+
+void Threading::FutureStateBase::PromiseDetached()
+{
+    if (0 != --m_promises)
+    {
+        return;
+    }
+
+    //
+    // The last promise is gone: nobody can set the result any more, so
+    // fail the waiters and continuations instead of leaving them hanging
+    // (and breaking the state -> continuation -> future cycle).
+    //
+    Continuations continuations;
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard lock(*this);
+        if (m_ready)
+        {
+            return;
+        }
+        m_exception.Reset(new FutureException(__FILE__, __LINE__, "broken promise"));
+        setReady(continuations);
+    }
+    runContinuations(continuations);
+}
+
+void Threading::FutureStateBase::checkNotReady() const
+{
+    if (m_ready)
+    {
+        throw FutureException(__FILE__, __LINE__, "promise already satisfied");
+    }
+}
+
+void Threading::FutureStateBase::setReady(Continuations& continuations)
+{
+    m_ready = true;
+    if (0 != m_waiters)
+    {
+        NotifyAll();
+    }
+    continuations.swap(m_continuations);
+}
+
+void Threading::FutureStateBase::runContinuations(const Continuations& continuations)
+{
+    for (Continuations::const_iterator iter = continuations.begin(); iter != continuations.end(); ++iter)
+    {
+        if (iter->second)
+        {
+            try
+            {
+                iter->second->SubmitTask(iter->first);
+                continue;
+            }
+            catch (const ThreadPoolDestroyedException&)
+            {
+                // The pool is gone, run the continuation here.
+            }
+        }
+
+        iter->first->Run();
+        iter->first->NotifyDone();
+    }
+}
+
+void Threading::FutureStateBase::waitReady() const
+{
+    WaitReady();
+    if (m_exception)
+    {
+        m_exception->Throw();
+    }
+}
@@ -0,0 +1,507 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <algorithm>
+#include <Concurrency/MemoryReclamation.h>
+#include <Concurrency/MutexPtrLock.h>
+#include <Concurrency/ThreadLocal.h>
+#include <Concurrency/Thread.h>
+
+THREADING_BEGIN
+
+namespace internal
+{
+
+//
+// The record of a thread in a domain, given back when the thread exits.
+//
+class ReclaimRecordHandle
+{
+public:
+
+    ReclaimRecordHandle() :
+        m_domain(0),
+        m_record(0)
+    {
+    }
+
+    // Only the empty default value is ever copied.
+    ReclaimRecordHandle(const ReclaimRecordHandle&) :
+        m_domain(0),
+        m_record(0)
+    {
+    }
+
+    ~ReclaimRecordHandle()
+    {
+        if (m_record)
+        {
+            m_domain->exitThread(m_record);
+        }
+    }
+
+    //
+    // Gives the record of the calling thread in domain back, from the
+    // Thread exit hook; its handle is destroyed later, if ever.
+    //
+    static void ExitThread(ReclaimDomain& domain)
+    {
+        ReclaimRecordHandle* handle = domain.m_handles->Find();
+        if (handle && handle->m_record)
+        {
+            ReclaimRecord* record = handle->m_record;
+            handle->m_record = 0;
+            domain.exitThread(record);
+        }
+    }
+
+    ReclaimDomain* m_domain;
+    ReclaimRecord* m_record;
+
+private:
+
+    ReclaimRecordHandle& operator =(const ReclaimRecordHandle&);
+};
+
+}
+
+THREADING_END
+
+namespace
+{
+
+Threading::Mutex* sDomainsMutex = 0;
+std::vector<Threading::internal::ReclaimDomain*>* sDomains = 0;    // The live domains.
+Threading::HazardPointerDomain* sHazardPointerDomain = 0;
+Threading::EpochDomain* sEpochDomain = 0;
+
+//
+// Gives the records of the exiting thread back to the domains, the
+// ThreadLocal destructors never run on Windows.
+//
+void
+exitThread()
+{
+    Threading::MutexPtrLock<Threading::Mutex> lock(sDomainsMutex);
+    if (0 == sDomains)
+    {
+        return;
+    }
+
+    for (std::vector<Threading::internal::ReclaimDomain*>::const_iterator iter = sDomains->begin();
+         iter != sDomains->end(); ++iter)
+    {
+        Threading::internal::ReclaimRecordHandle::ExitThread(**iter);
+    }
+}
+
+class Init
+{
+public:
+
+    Init()
+    {
+        sDomainsMutex = new Threading::Mutex;
+        sDomains = new std::vector<Threading::internal::ReclaimDomain*>;
+        sHazardPointerDomain = new Threading::HazardPointerDomain;
+        sEpochDomain = new Threading::EpochDomain;
+        Threading::internal::AddThreadExitHook(&exitThread);
+    }
+
+    ~Init()
+    {
+        delete sEpochDomain;
+        sEpochDomain = 0;
+        delete sHazardPointerDomain;
+        sHazardPointerDomain = 0;
+        delete sDomains;
+        sDomains = 0;
+        delete sDomainsMutex;
+        sDomainsMutex = 0;
+    }
+};
+
+Init init;
+
+//
+// The state of a thread in an EpochDomain: the epoch it entered its
+// outermost guard in, shifted, plus ActiveFlag while it is in a guard.
+//
+const unsigned int ActiveFlag = 1;
+
+}
+
+Threading::internal::ReclaimDomain::ReclaimDomain() :
+    m_records(0),
+    m_handles(new ThreadLocal<ReclaimRecordHandle>),
+    m_hasOrphans(0)
+{
+    Threading::MutexPtrLock<Threading::Mutex> lock(sDomainsMutex);
+    if (0 != sDomains)
+    {
+        sDomains->push_back(this);
+    }
+}
+
+Threading::internal::ReclaimDomain::~ReclaimDomain()
+{
+    shutdown();
+}
+
+void
+Threading::internal::ReclaimDomain::Retire(void* object, void (*deleter)(void*))
+{
+    if (0 == m_handles)
+    {
+        // Retired by a deleter while the domain is destroyed.
+        deleter(object);
+        return;
+    }
+
+    ReclaimRecord* current = record();
+    RetiredObject retired = { object, deleter, retireEpoch() };
+    current->m_retired.push_back(retired);
+    if (current->m_retired.size() >= Threshold)
+    {
+        reclaim(current);
+    }
+}
+
+void
+Threading::internal::ReclaimDomain::Reclaim()
+{
+    reclaim(record());
+}
+
+Threading::internal::ReclaimRecord*
+Threading::internal::ReclaimDomain::record()
+{
+    ReclaimRecordHandle* handle = m_handles->Pointer();
+    if (handle->m_record)
+    {
+        return handle->m_record;
+    }
+
+    //
+    // Reuses the record of a thread that exited, or adds one.
+    //
+    ReclaimRecord* current = records();
+    for (; current; current = current->m_next)
+    {
+        int inUse = 0;
+        if (0 == AtomicLoad(&current->m_inUse, MemoryOrderRelaxed) &&
+            AtomicCompareExchange(&current->m_inUse, inUse, 1, MemoryOrderAcquire))
+        {
+            break;
+        }
+    }
+
+    if (!current)
+    {
+        current = new ReclaimRecord();
+        current->m_inUse = 1;
+        current->m_state = 0;
+        current->m_guards = 0;
+        ReclaimRecord* head = AtomicLoad(&m_records, MemoryOrderRelaxed);
+        do
+        {
+            current->m_next = head;
+        }
+        while (!AtomicCompareExchange(&m_records, head, current, MemoryOrderRelease));
+    }
+
+    handle->m_domain = this;
+    handle->m_record = current;
+    return current;
+}
+
+void
+Threading::internal::ReclaimDomain::reclaim(ReclaimRecord* record)
+{
+    if (0 != AtomicLoad(&m_hasOrphans, MemoryOrderRelaxed))
+    {
+        Threading::Mutex::LockGuard sync(m_mutex);
+        record->m_retired.insert(record->m_retired.end(), m_orphans.begin(), m_orphans.end());
+        m_orphans.clear();
+        AtomicStore(&m_hasOrphans, 0, MemoryOrderRelaxed);
+    }
+
+    if (!record->m_retired.empty())
+    {
+        scan(record->m_retired);
+    }
+}
+
+void
+Threading::internal::ReclaimDomain::exitThread(ReclaimRecord* record)
+{
+    if (!record->m_retired.empty())
+    {
+        scan(record->m_retired);
+    }
+
+    if (!record->m_retired.empty())
+    {
+        Threading::Mutex::LockGuard sync(m_mutex);
+        m_orphans.insert(m_orphans.end(), record->m_retired.begin(), record->m_retired.end());
+        AtomicStore(&m_hasOrphans, 1, MemoryOrderRelaxed);
+    }
+
+    //
+    // The next thread may get a record with a large capacity, but not the
+    // objects of this one.
+    //
+    record->m_retired.clear();
+    record->m_guards = 0;
+    AtomicStore(&record->m_state, 0u, MemoryOrderRelaxed);
+    AtomicStore(&record->m_inUse, 0, MemoryOrderRelease);
+}
+
+void
+Threading::internal::ReclaimDomain::shutdown()
+{
+    //
+    // Exits the calling thread first, as long as the derived class can
+    // still scan; the handles of the other threads are not destroyed by
+    // the ThreadLocal any more, their objects are deleted below.
+    //
+    {
+        Threading::MutexPtrLock<Threading::Mutex> lock(sDomainsMutex);
+        if (0 != sDomains)
+        {
+            sDomains->erase(std::remove(sDomains->begin(), sDomains->end(), this), sDomains->end());
+        }
+    }
+
+    ThreadLocal<ReclaimRecordHandle>* handles = m_handles;
+    m_handles = 0;
+    delete handles;
+
+    ReclaimRecord* current = AtomicExchange(&m_records, static_cast<ReclaimRecord*>(0));
+    while (current)
+    {
+        ReclaimRecord* next = current->m_next;
+        deleteRetired(current->m_retired);
+        delete current;
+        current = next;
+    }
+    deleteRetired(m_orphans);
+}
+
+void
+Threading::internal::ReclaimDomain::deleteRetired(std::vector<RetiredObject>& retired)
+{
+    //
+    // A deleter may retire objects in turn, e.g. the nodes a node owns.
+    //
+    std::vector<RetiredObject> objects;
+    objects.swap(retired);
+    for (std::vector<RetiredObject>::const_iterator iter = objects.begin(); iter != objects.end(); ++iter)
+    {
+        iter->m_deleter(iter->m_object);
+    }
+}
+
+Threading::HazardPointerDomain::HazardPointerDomain() :
+    m_hazards(0)
+{
+}
+
+Threading::HazardPointerDomain::~HazardPointerDomain()
+{
+    shutdown();
+
+    internal::HazardRecord* current = AtomicExchange(&m_hazards, static_cast<internal::HazardRecord*>(0));
+    while (current)
+    {
+        internal::HazardRecord* next = current->m_next;
+        delete current;
+        current = next;
+    }
+}
+
+Threading::HazardPointerDomain&
+Threading::HazardPointerDomain::Default()
+{
+    return *sHazardPointerDomain;
+}
+
+unsigned int
+Threading::HazardPointerDomain::retireEpoch()
+{
+    return 0;
+}
+
+void
+Threading::HazardPointerDomain::scan(std::vector<internal::RetiredObject>& retired)
+{
+    //
+    // The objects were unlinked before they were retired: a hazard pointer
+    // set after that does not refer to them, or its Protect() fails.
+    //
+    AtomicThreadFence(MemoryOrderSeqCst);
+
+    std::vector<const void*> hazards;
+    for (internal::HazardRecord* current = AtomicLoad(&m_hazards, MemoryOrderAcquire); current; current = current->m_next)
+    {
+        const void* pointer = AtomicLoad(&current->m_pointer);
+        if (pointer)
+        {
+            hazards.push_back(pointer);
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    std::vector<internal::RetiredObject> unreachable;
+    std::vector<internal::RetiredObject>::iterator kept = retired.begin();
+    for (std::vector<internal::RetiredObject>::iterator iter = retired.begin(); iter != retired.end(); ++iter)
+    {
+        if (std::binary_search(hazards.begin(), hazards.end(), static_cast<const void*>(iter->m_object)))
+        {
+            *kept++ = *iter;
+        }
+        else
+        {
+            unreachable.push_back(*iter);
+        }
+    }
+    retired.erase(kept, retired.end());
+    deleteRetired(unreachable);
+}
+
+Threading::internal::HazardRecord*
+Threading::HazardPointerDomain::acquire()
+{
+    for (internal::HazardRecord* current = AtomicLoad(&m_hazards, MemoryOrderAcquire); current; current = current->m_next)
+    {
+        int inUse = 0;
+        if (0 == AtomicLoad(&current->m_inUse, MemoryOrderRelaxed) &&
+            AtomicCompareExchange(&current->m_inUse, inUse, 1, MemoryOrderAcquire))
+        {
+            return current;
+        }
+    }
+
+    internal::HazardRecord* record = new internal::HazardRecord();
+    record->m_inUse = 1;
+    record->m_pointer = 0;
+    internal::HazardRecord* head = AtomicLoad(&m_hazards, MemoryOrderRelaxed);
+    do
+    {
+        record->m_next = head;
+    }
+    while (!AtomicCompareExchange(&m_hazards, head, record, MemoryOrderRelease));
+    return record;
+}
+
+void
+Threading::HazardPointerDomain::release(internal::HazardRecord* record)
+{
+    AtomicStore(&record->m_pointer, static_cast<const void*>(0), MemoryOrderRelaxed);
+    AtomicStore(&record->m_inUse, 0, MemoryOrderRelease);
+}
+
+Threading::HazardPointer::HazardPointer(HazardPointerDomain& domain) :
+    m_record(domain.acquire())
+{
+}
+
+Threading::HazardPointer::~HazardPointer()
+{
+    HazardPointerDomain::release(m_record);
+}
+
+Threading::EpochDomain::EpochDomain() :
+    m_epoch(0)
+{
+}
+
+Threading::EpochDomain::~EpochDomain()
+{
+    shutdown();
+}
+
+Threading::EpochDomain&
+Threading::EpochDomain::Default()
+{
+    return *sEpochDomain;
+}
+
+unsigned int
+Threading::EpochDomain::retireEpoch()
+{
+    return AtomicLoad(&m_epoch);
+}
+
+void
+Threading::EpochDomain::scan(std::vector<internal::RetiredObject>& retired)
+{
+    tryAdvance();
+
+    //
+    // A thread that could reach an object retired in epoch e was in a guard
+    // entered in epoch e at the latest, the epoch cannot go past e + 1
+    // before it leaves.
+    //
+    unsigned int epoch = AtomicLoad(&m_epoch);
+    std::vector<internal::RetiredObject> unreachable;
+    std::vector<internal::RetiredObject>::iterator kept = retired.begin();
+    for (std::vector<internal::RetiredObject>::iterator iter = retired.begin(); iter != retired.end(); ++iter)
+    {
+        if (epoch - iter->m_epoch < 2)
+        {
+            *kept++ = *iter;
+        }
+        else
+        {
+            unreachable.push_back(*iter);
+        }
+    }
+    retired.erase(kept, retired.end());
+    deleteRetired(unreachable);
+}
+
+Threading::internal::ReclaimRecord*
+Threading::EpochDomain::enter()
+{
+    internal::ReclaimRecord* current = record();
+    if (0 == current->m_guards++)
+    {
+        AtomicStore(&current->m_state, (AtomicLoad(&m_epoch) << 1) | ActiveFlag, MemoryOrderRelaxed);
+        AtomicThreadFence(MemoryOrderSeqCst);
+    }
+    return current;
+}
+
+void
+Threading::EpochDomain::leave(internal::ReclaimRecord* record)
+{
+    if (0 == --record->m_guards)
+    {
+        AtomicStore(&record->m_state, 0u, MemoryOrderRelease);
+    }
+}
+
+//
+// The epoch advances once every thread in a guard entered it in the
+// current epoch.
+//
+bool
+Threading::EpochDomain::tryAdvance()
+{
+    unsigned int epoch = AtomicLoad(&m_epoch);
+    for (internal::ReclaimRecord* current = records(); current; current = current->m_next)
+    {
+        unsigned int state = AtomicLoad(&current->m_state);
+        if (0 != (state & ActiveFlag) && (state >> 1) != (epoch & (~0u >> 1)))
+        {
+            return false;
+        }
+    }
+    return AtomicCompareExchange(&m_epoch, epoch, epoch + 1);
+}
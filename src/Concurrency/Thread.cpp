@@ -9,6 +9,33 @@
 #include <Concurrency/Thread.h>
 #include <Concurrency/ThreadException.h>
 
+namespace
+{
+
+const int MaxExitHooks = 8;
+
+void (*sExitHooks[MaxExitHooks])();
+int sExitHookCount = 0;
+
+// Called by the calling thread once its Run() returned.
+void
+runExitHooks()
+{
+    for (int i = sExitHookCount - 1; i >= 0; --i)
+    {
+        sExitHooks[i]();
+    }
+}
+
+}
+
+void
+Threading::internal::AddThreadExitHook(void (*hook)())
+{
+    assert(sExitHookCount < MaxExitHooks);
+    sExitHooks[sExitHookCount++] = hook;
+}
+
 #ifdef LANG_CPP11
 
 Threading::Thread::Thread() :
@@ -68,6 +95,7 @@ static unsigned int
         std::terminate();
     }
 
+    runExitHooks();
     thread->_done();
 
     return 0;
@@ -105,6 +133,28 @@ Threading::Thread::Start(size_t, int)
     return ThreadControl(m_thread);
 }
 
+Threading::ThreadControl
+Threading::Thread::Start(size_t stack_size, const CpuSet& cpus)
+{
+    ThreadControl control = Start(stack_size);
+    if (!cpus.Empty())
+    {
+        control.SetAffinity(cpus);
+    }
+    return control;
+}
+
+Threading::ThreadControl
+Threading::Thread::Start(size_t stack_size, int priority, const CpuSet& cpus)
+{
+    ThreadControl control = Start(stack_size, priority);
+    if (!cpus.Empty())
+    {
+        control.SetAffinity(cpus);
+    }
+    return control;
+}
+
 Threading::ThreadControl
 Threading::Thread::GetThreadControl() const
 {
@@ -175,17 +225,44 @@ WINAPI StartHook(void* arg)
 #endif
     }
 
+    runExitHooks();
     thread->_done();
 
     return 0;
 }
 
+static bool setAffinity(HANDLE thread, const Threading::CpuSet& cpus)
+{
+    DWORD_PTR mask = 0;
+    std::vector<size_t> list = cpus.Cpus();
+    for (size_t i = 0; i < list.size() && list[i] < sizeof(DWORD_PTR) * 8; ++i)
+    {
+        mask |= static_cast<DWORD_PTR>(1) << list[i];
+    }
+    return 0 != SetThreadAffinityMask(thread, mask);
+}
+
 Threading::ThreadControl Threading::Thread::Start(size_t stack_size)
 {
     return Start(stack_size, THREAD_PRIORITY_NORMAL);
 }
 
 Threading::ThreadControl Threading::Thread::Start(size_t stack_size, int priority)
+{
+    return Start(stack_size, priority, 0);
+}
+
+Threading::ThreadControl Threading::Thread::Start(size_t stack_size, const CpuSet& cpus)
+{
+    return Start(stack_size, THREAD_PRIORITY_NORMAL, &cpus);
+}
+
+Threading::ThreadControl Threading::Thread::Start(size_t stack_size, int priority, const CpuSet& cpus)
+{
+    return Start(stack_size, priority, &cpus);
+}
+
+Threading::ThreadControl Threading::Thread::Start(size_t stack_size, int priority, const CpuSet* cpus)
 {
     ThreadPtr keepMe(this);
 
@@ -206,6 +283,7 @@ Threading::ThreadControl Threading::Thread::Start(size_t stack_size, int priorit
     assert(m_thread != (HANDLE)-1L);
     if (0 == m_thread ||
         false == SetThreadPriority(m_thread, priority) ||
+        (cpus && !cpus->Empty() && !setAffinity(m_thread, *cpus)) ||
         -1 == ResumeThread(m_thread))
     {
         DecRef();
@@ -274,6 +352,7 @@ static void* StartHook(void* arg)
         std::terminate();
     }
 
+    runExitHooks();
     thread->_done();
 
     return 0;
@@ -283,15 +362,25 @@ static void* StartHook(void* arg)
 
 Threading::ThreadControl Threading::Thread::Start(size_t stack_size)
 {
-    return Start(stack_size, false, 0);
+    return Start(stack_size, false, 0, 0);
 }
 
 Threading::ThreadControl Threading::Thread::Start(size_t stack_size, int priority)
 {
-    return Start(stack_size, true, priority);
+    return Start(stack_size, true, priority, 0);
+}
+
+Threading::ThreadControl Threading::Thread::Start(size_t stack_size, const CpuSet& cpus)
+{
+    return Start(stack_size, false, 0, &cpus);
+}
+
+Threading::ThreadControl Threading::Thread::Start(size_t stack_size, int priority, const CpuSet& cpus)
+{
+    return Start(stack_size, true, priority, &cpus);
 }
 
-Threading::ThreadControl  Threading::Thread::Start(size_t stack_size, bool realtime_scheduling, int priority)
+Threading::ThreadControl  Threading::Thread::Start(size_t stack_size, bool realtime_scheduling, int priority, const CpuSet* cpus)
 {
     Threading::ThreadPtr keepMe = this;
 
@@ -357,6 +446,22 @@ Threading::ThreadControl  Threading::Thread::Start(size_t stack_size, bool realt
         pthread_attr_setinheritsched(&thread_attr, PTHREAD_EXPLICIT_SCHED);
     }
 
+#if defined(__linux)
+    // Pinned from the start, so the thread's first allocations are local.
+    if (cpus && !cpus->Empty())
+    {
+        cpu_set_t set;
+        cpus->Fill(set);
+        returnVal = pthread_attr_setaffinity_np(&thread_attr, sizeof(set), &set);
+        if (0 != returnVal)
+        {
+            DecRef();
+            pthread_attr_destroy(&thread_attr);
+            throw ThreadSyscallException(__FILE__, __LINE__, returnVal);
+        }
+    }
+#endif
+
     returnVal = pthread_create(&m_thread, &thread_attr, StartHook, this);
     pthread_attr_destroy(&thread_attr);
     if (0 != returnVal)
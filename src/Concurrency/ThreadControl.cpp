@@ -240,3 +240,56 @@ void Threading::ThreadControl::Yield()
 }
 
 #endif
+
+void Threading::ThreadControl::SetAffinity(const CpuSet& cpus)
+{
+    if (cpus.Empty())
+    {
+        throw IllegalArgumentException(__FILE__, __LINE__, "empty CPU set");
+    }
+
+#if defined(_WIN32)
+#   ifdef LANG_CPP11
+    HANDLE thread = m_thread ? m_thread->native_handle() : GetCurrentThread();
+#   else
+    HANDLE thread = m_thread ? m_thread : GetCurrentThread();
+#   endif
+
+    DWORD_PTR mask = 0;
+    std::vector<size_t> list = cpus.Cpus();
+    for (size_t i = 0; i < list.size() && list[i] < sizeof(DWORD_PTR) * 8; ++i)
+    {
+        mask |= static_cast<DWORD_PTR>(1) << list[i];
+    }
+
+    if (0 == SetThreadAffinityMask(thread, mask))
+    {
+        throw ThreadSyscallException(__FILE__, __LINE__, GetLastError());
+    }
+#elif defined(__linux)
+#   ifdef LANG_CPP11
+    pthread_t thread = m_thread ? m_thread->native_handle() : pthread_self();
+#   else
+    pthread_t thread = m_thread;
+#   endif
+
+    cpu_set_t set;
+    cpus.Fill(set);
+    int result = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (0 != result)
+    {
+        throw ThreadSyscallException(__FILE__, __LINE__, result);
+    }
+#endif
+}
+
+void Threading::ThreadControl::Pause()
+{
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    __asm__ __volatile__("pause");
+#elif defined(__GNUC__) && defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
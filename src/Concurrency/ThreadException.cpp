@@ -265,4 +265,49 @@ void
 Threading::ThreadPoolDestroyedException::Throw() const
 {
     throw *this;
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// class FutureException
+Threading::FutureException::FutureException(
+    const char *file, int line, const std::string& reason) :
+    Exception(file, line), m_reason(reason)
+{
+}
+
+Threading::FutureException::~FutureException() throw()
+{
+}
+
+const char* Threading::FutureException::ms_pcName = "Threading::FutureException";
+
+std::string
+Threading::FutureException::Name() const
+{
+    return ms_pcName;
+}
+
+void 
+Threading::FutureException::Print(std::ostream& out) const
+{
+    Exception::Print(out);
+    out << ": " << m_reason;
+}
+
+Threading::Exception*
+Threading::FutureException::Clone() const
+{
+    return new FutureException(*this);
+}
+
+void
+Threading::FutureException::Throw() const
+{
+    throw *this;
+}
+
+const std::string&
+Threading::FutureException::Reason() const
+{
+    return m_reason;
+}
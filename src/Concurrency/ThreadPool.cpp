@@ -7,6 +7,355 @@
 // **********************************************************************
 
 #include <Concurrency/ThreadPool.h>
+#include <algorithm>
+#include <map>
+
+namespace
+{
+
+//
+// Limits of the messages an overloaded or misused pool would otherwise
+// log on every event: "running low on threads" at most once every
+// LowThreadsInterval seconds, task and submission errors ErrorBurst at
+// once then ErrorRate per second.
+//
+const double LowThreadsInterval = 60;
+const double ErrorRate = 1;
+const double ErrorBurst = 10;
+
+//
+// Per-thread cache of SmallTask blocks. A task is usually freed by the
+// worker that ran it, not by the thread that submitted it, so every block
+// remembers the cache it was allocated from and goes back there: the
+// owner keeps it on its own list, another thread pushes it on the owner's
+// lock-free return stack, which the owner takes over whole once its own
+// list is empty. The owner's list is capped, the surplus goes back to the
+// heap.
+//
+const size_t SmallTaskFreeListMax = 1024;
+
+class SmallTaskCache;
+
+// Precedes every block, as aligned as the task that follows it.
+union SmallTaskBlock
+{
+    SmallTaskCache* m_owner;
+    long double m_alignld;
+    Threading::Int64 m_align64;
+};
+
+inline void*&
+nextBlock(SmallTaskBlock* block)
+{
+    return *reinterpret_cast<void**>(block + 1);
+}
+
+class SmallTaskCache
+{
+public:
+
+    SmallTaskCache() :
+        m_head(0),
+        m_count(0),
+        m_returned(0),
+        m_blocks(1)
+    {
+    }
+
+    // Owner thread only.
+    void* Allocate()
+    {
+        if (!m_head)
+        {
+            m_head = static_cast<SmallTaskBlock*>(AtomicExchange(&m_returned, static_cast<void*>(0), Threading::MemoryOrderAcquire));
+            for (SmallTaskBlock* block = m_head; block; block = static_cast<SmallTaskBlock*>(nextBlock(block)))
+            {
+                ++m_count;
+            }
+        }
+
+        SmallTaskBlock* block = m_head;
+        if (block)
+        {
+            m_head = static_cast<SmallTaskBlock*>(nextBlock(block));
+            --m_count;
+        }
+        else
+        {
+            block = static_cast<SmallTaskBlock*>(::operator new(sizeof(SmallTaskBlock) + sizeof(Threading::SmallTask)));
+            block->m_owner = this;
+            ++m_blocks;
+        }
+        return block + 1;
+    }
+
+    // Owner thread only.
+    void Free(SmallTaskBlock* block)
+    {
+        if (m_count < SmallTaskFreeListMax)
+        {
+            nextBlock(block) = m_head;
+            m_head = block;
+            ++m_count;
+            return;
+        }
+        release(block);
+    }
+
+    // Any other thread.
+    void Return(SmallTaskBlock* block)
+    {
+        void* head = AtomicLoad(&m_returned, Threading::MemoryOrderRelaxed);
+        do
+        {
+            if (closed() == head)
+            {
+                release(block);
+                return;
+            }
+            nextBlock(block) = head;
+        }
+        while (!AtomicCompareExchange(&m_returned, head, static_cast<void*>(block), Threading::MemoryOrderRelease));
+    }
+
+    //
+    // The owner thread exits: its blocks go back to the heap, those still
+    // in use when they are freed. The cache goes with the last of them.
+    //
+    void Close()
+    {
+        SmallTaskBlock* returned = static_cast<SmallTaskBlock*>(AtomicExchange(&m_returned, closed(), Threading::MemoryOrderAcquire));
+        releaseAll(m_head);
+        releaseAll(returned);
+        m_head = 0;
+        if (0 == --m_blocks)
+        {
+            delete this;
+        }
+    }
+
+private:
+
+    static void* closed()
+    {
+        static char closed;
+        return &closed;
+    }
+
+    void releaseAll(SmallTaskBlock* block)
+    {
+        while (block)
+        {
+            SmallTaskBlock* next = static_cast<SmallTaskBlock*>(nextBlock(block));
+            release(block);
+            block = next;
+        }
+    }
+
+    void release(SmallTaskBlock* block)
+    {
+        ::operator delete(block);
+        if (0 == --m_blocks)
+        {
+            delete this;
+        }
+    }
+
+    SmallTaskBlock* m_head;         // Owner thread only.
+    size_t m_count;
+    void* volatile m_returned;      // Blocks freed by other threads, or closed().
+    Threading::AtomicInt m_blocks;  // Blocks allocated and not released, plus one for the owner.
+};
+
+class SmallTaskCacheHandle
+{
+public:
+
+    SmallTaskCacheHandle() :
+        m_cache(0)
+    {
+    }
+
+    // Only the empty default value is ever copied.
+    SmallTaskCacheHandle(const SmallTaskCacheHandle&) :
+        m_cache(0)
+    {
+    }
+
+    ~SmallTaskCacheHandle()
+    {
+        if (m_cache)
+        {
+            m_cache->Close();
+        }
+    }
+
+    SmallTaskCache* m_cache;
+
+private:
+
+    SmallTaskCacheHandle& operator =(const SmallTaskCacheHandle&);
+};
+
+// Never deleted: tasks may still be freed while static objects are destroyed.
+Threading::ThreadLocal<SmallTaskCacheHandle>* smallTaskCaches = new Threading::ThreadLocal<SmallTaskCacheHandle>();
+
+Threading::AbstractQueue<Threading::TaskBase>* createTaskQueue(const std::string& type, size_t capacity)
+{
+    if ("ring" == type)
+    {
+        return new Threading::AbstractQueueI<Threading::RingQueue<Threading::TaskBase> >(capacity);
+    }
+    else if ("twolock" == type)
+    {
+        return new Threading::AbstractQueueI<Threading::ThreadSafeQueue<Threading::TaskBase, Threading::TwoLockQueuePolicy> >();
+    }
+    return new Threading::AbstractQueueI<Threading::ThreadSafeQueue<Threading::TaskBase> >();
+}
+
+}
+
+void Threading::TaskBase::Reset()
+{
+    m_done = false;
+    Threading::AtomicThreadFence();
+}
+
+Threading::Monitor<Threading::Mutex>* Threading::TaskBase::getMonitor() const
+{
+    Threading::Monitor<Threading::Mutex>* monitor = m_monitor;
+    if (monitor)
+    {
+        return monitor;
+    }
+
+    monitor = new Threading::Monitor<Threading::Mutex>();
+    Threading::Monitor<Threading::Mutex>* current = 0;
+    if (!Threading::AtomicCompareExchange(&m_monitor, current, monitor))
+    {
+        delete monitor;         // another waiter won
+        return current;
+    }
+    return monitor;
+}
+
+void Threading::TaskBase::WaitDone() const
+{
+    if (m_done)
+    {
+        return;
+    }
+
+    Threading::Monitor<Threading::Mutex>* monitor = getMonitor();
+    Threading::Monitor<Threading::Mutex>::LockGuard lock(*monitor);
+    while (!m_done)
+    {
+        try 
+        {
+            ++m_waiters;
+            monitor->Wait();
+            --m_waiters;
+        } 
+        catch (...) 
+        {
+            --m_waiters;
+            throw;
+        }
+    }
+}
+
+bool Threading::TaskBase::TimedWaitDone(const Time& timeout) const
+{
+    if (m_done)
+    {
+        return true;
+    }
+
+    Threading::Monitor<Threading::Mutex>* monitor = getMonitor();
+    Threading::Monitor<Threading::Mutex>::LockGuard lock(*monitor);
+
+    if (m_done)
+    {
+        return true;
+    }
+
+    bool returnVal = false;
+
+    try 
+    {
+        ++m_waiters;
+        returnVal = monitor->TimedWait(timeout);
+        --m_waiters;
+    } 
+    catch (...) 
+    {
+        --m_waiters;
+        throw;
+    }
+
+    return returnVal || m_done;
+}
+
+void Threading::TaskBase::NotifyDone() const
+{
+    //
+    // Pairs with the CAS in getMonitor(): either the waiter finds m_done
+    // set when it checks under the monitor, or we find its monitor here.
+    //
+    m_done = true;
+    Threading::AtomicThreadFence();
+
+    Threading::Monitor<Threading::Mutex>* monitor = m_monitor;
+    if (!monitor)
+    {
+        return;
+    }
+
+    Threading::Monitor<Threading::Mutex>::LockGuard lock(*monitor);
+    if (0 != m_waiters)
+    {
+        monitor->NotifyAll();
+    }
+}
+
+void* Threading::SmallTask::operator new(size_t size)
+{
+    if (size != sizeof(SmallTask))
+    {
+        return ::operator new(size);
+    }
+
+    SmallTaskCacheHandle* handle = smallTaskCaches->Pointer();
+    if (!handle->m_cache)
+    {
+        handle->m_cache = new SmallTaskCache();
+    }
+    return handle->m_cache->Allocate();
+}
+
+void Threading::SmallTask::operator delete(void* ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    if (size != sizeof(SmallTask))
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    SmallTaskBlock* block = static_cast<SmallTaskBlock*>(ptr) - 1;
+    if (block->m_owner == smallTaskCaches->Pointer()->m_cache)
+    {
+        block->m_owner->Free(block);
+    }
+    else
+    {
+        block->m_owner->Return(block);
+    }
+}
 
 void Threading::ThreadJoiner(const ThreadPtr& thread)
 {
@@ -20,18 +369,29 @@ Threading::ThreadPool::ThreadPool(int threadnum
                              , const std::string& poolname
                              , const std::string& logger_file) : 
     m_destroyed(false), 
+    m_tasksqueue(new AbstractQueueI<ThreadSafeQueue<TaskBase> >()),
+    m_lanequeue(0),
     m_joiner(m_threads),
     m_size(threadnum),
     m_sizemax(threadnum),
     m_sizewarn(threadnum),
     m_inuse(0),
-    m_waitifnotask(true),
+    m_idlethreads(0),
     m_haspriority(false),
+    m_workstealing(false),
+    m_boundedqueue(false),
+    m_batchsize(1),
+    m_spincount(100),
+    m_yieldcount(10),
     m_shrinkcycletime(0),
     m_threadidletime(0),
     m_priority(0),
     m_stacksize(0), 
-    m_poolname(poolname)
+    m_poolname(poolname),
+    m_lowthreadslog(),
+    m_taskerrorlog(),
+    m_destroyedlog(),
+    m_workerindex(-1)
 {
     m_logger = new Logger(m_poolname, logger_file);
 
@@ -39,7 +399,7 @@ Threading::ThreadPool::ThreadPool(int threadnum
     {
         for (unsigned i = 0; i < m_size; ++i)
         {
-            m_threads.insert(new TaskThread(*this));
+            m_threads.insert(new TaskThread(*this, nextWorkerIndex()));
         }
     }
     catch(const Threading::Exception& ex)
@@ -57,23 +417,34 @@ Threading::ThreadPool::ThreadPool(const std::string& properties_file,
                              const std::string& logger_file, 
                              const std::string& poolname) :
     m_destroyed(false), 
+    m_tasksqueue(new AbstractQueueI<ThreadSafeQueue<TaskBase> >()),
+    m_lanequeue(0),
     m_joiner(m_threads),
     m_size(0),
     m_sizemax(0),
     m_sizewarn(0),
     m_inuse(0),
-    m_waitifnotask(false),
+    m_idlethreads(0),
     m_haspriority(false),
+    m_workstealing(false),
+    m_boundedqueue(false),
+    m_batchsize(1),
+    m_spincount(100),
+    m_yieldcount(10),
     m_shrinkcycletime(0),
     m_threadidletime(0),
     m_priority(0),
     m_stacksize(0), 
-    m_poolname(poolname)
+    m_poolname(poolname),
+    m_lowthreadslog(),
+    m_taskerrorlog(),
+    m_destroyedlog(),
+    m_workerindex(-1)
 {
     m_properties = CreateProperties(0);
     m_properties->Load(properties_file);
     
-    m_logger = new Logger(m_poolname, logger_file);
+    m_logger = new Logger(m_poolname, logger_file, LogRotation::Load(m_properties, m_poolname + ".Log"));
 
 #ifndef OS_WINRT
 #   ifdef _WIN32
@@ -134,18 +505,47 @@ Threading::ThreadPool::ThreadPool(const std::string& properties_file,
     }
     const_cast<size_t&>(m_stacksize) = static_cast<size_t>(stackSize);
 
-    const_cast<bool&>(m_waitifnotask) = "true" == Threading::ToLower(m_properties->GetProperty(m_poolname + ".WaitIfNoTask"));
-    if (m_waitifnotask)
+    //
+    // How long a parked worker stays idle before the shrinker may retire
+    // it, see ShrinkCycleTime below. Idle workers always park, see
+    // SpinCount and YieldCount; the former WaitIfNoTask is ignored.
+    //
+    int threadIdleTime = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".ThreadIdleTime", 0);
+    if (threadIdleTime < 0)
     {
-        int threadIdleTime = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".ThreadIdleTime", 6000);
-        if (threadIdleTime < 0)
-        {
-            Warning out(m_logger);
-            out << m_poolname << ".ThreadIdleTime < 0; ThreadIdleTime adjusted to 0 milliseconds";
-            threadIdleTime = 0;
-        }
-        const_cast<Int64&>(m_threadidletime) = threadIdleTime;
+        Warning out(m_logger);
+        out << m_poolname << ".ThreadIdleTime < 0; ThreadIdleTime adjusted to 0 milliseconds";
+        threadIdleTime = 0;
+    }
+    const_cast<Int64&>(m_threadidletime) = threadIdleTime;
+
+    //
+    // An idle thread spins SpinCount rounds, then yields YieldCount rounds and
+    // then parks until a task is submitted. A negative YieldCount never parks.
+    //
+    int spinCount = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".SpinCount", 100);
+    if (spinCount < 0)
+    {
+        Warning out(m_logger);
+        out << m_poolname << ".SpinCount < 0; SpinCount adjusted to 0";
+        spinCount = 0;
     }
+    const_cast<int&>(m_spincount) = spinCount;
+    const_cast<int&>(m_yieldcount) = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".YieldCount", 10);
+
+    //
+    // Every ShrinkCycleTime seconds the threads above Size that have been
+    // idle for ThreadIdleTime milliseconds (a whole cycle if ThreadIdleTime
+    // is 0) are retired.
+    //
+    int shrinkCycleTime = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".ShrinkCycleTime", 60);
+    if (shrinkCycleTime < 0)
+    {
+        Warning out(m_logger);
+        out << m_poolname << ".ShrinkCycleTime < 0; ShrinkCycleTime adjusted to 0 (never shrink)";
+        shrinkCycleTime = 0;
+    }
+    const_cast<Int64&>(m_shrinkcycletime) = shrinkCycleTime;
         
     const_cast<bool&>(m_haspriority) = "" != m_properties->GetProperty(m_poolname + ".ThreadPriority");
     const_cast<int&>(m_priority) = m_properties->GetPropertyAsInt(m_poolname + ".ThreadPriority");
@@ -155,12 +555,196 @@ Threading::ThreadPool::ThreadPool(const std::string& properties_file,
         const_cast<int&>(m_priority) = m_properties->GetPropertyAsInt("ThreadPriority");
     }
 
+    std::string taskqueue = Threading::ToLower(m_properties->GetProperty(m_poolname + ".TaskQueue"));
+    int capacity = 1024;
+    if ("ring" == taskqueue)
+    {
+        // Bounded: SubmitTask blocks while the ring is full, but on workers.
+        const_cast<bool&>(m_boundedqueue) = true;
+        capacity = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".TaskQueueCapacity", 1024);
+        if (capacity < 1)
+        {
+            Warning out(m_logger);
+            out << m_poolname << ".TaskQueueCapacity < 1; TaskQueueCapacity adjusted to 1024";
+            capacity = 1024;
+        }
+    }
+    else if (!taskqueue.empty() && "twolock" != taskqueue && "list" != taskqueue)
+    {
+        Warning out(m_logger);
+        out << m_poolname << ".TaskQueue `" << taskqueue << "' is unknown; TaskQueue adjusted to List";
+        taskqueue = "list";
+    }
+
+    //
+    // TaskLanes > 1 splits the queue into priority lanes of the TaskQueue
+    // type, lane 0 being the most urgent. SubmitTask(task) uses the lane
+    // TaskDefaultLane and every TaskLaneAging-th pop is served from the
+    // lowest non-empty lane, so batch work isn't starved (0 never is).
+    //
+    int lanes = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".TaskLanes", 1);
+    if (lanes < 1)
+    {
+        Warning out(m_logger);
+        out << m_poolname << ".TaskLanes < 1; TaskLanes adjusted to 1";
+        lanes = 1;
+    }
+
+    if (lanes > 1)
+    {
+        int defaultLane = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".TaskDefaultLane", 0);
+        if (defaultLane < 0 || defaultLane >= lanes)
+        {
+            Warning out(m_logger);
+            out << m_poolname << ".TaskDefaultLane is not a lane; TaskDefaultLane adjusted to 0";
+            defaultLane = 0;
+        }
+
+        int aging = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".TaskLaneAging", 16);
+        if (aging < 0)
+        {
+            Warning out(m_logger);
+            out << m_poolname << ".TaskLaneAging < 0; TaskLaneAging adjusted to 0";
+            aging = 0;
+        }
+
+        std::vector<AbstractQueue<TaskBase>*> queues;
+        for (int i = 0; i < lanes; ++i)
+        {
+            queues.push_back(createTaskQueue(taskqueue, static_cast<size_t>(capacity)));
+        }
+        m_lanequeue = new LaneQueue<TaskBase>(queues, static_cast<size_t>(defaultLane), static_cast<size_t>(aging));
+        m_tasksqueue.Reset(m_lanequeue);
+    }
+    else
+    {
+        m_tasksqueue.Reset(createTaskQueue(taskqueue, static_cast<size_t>(capacity)));
+    }
+
+    int batchSize = m_properties->GetPropertyAsIntWithDefault(m_poolname + ".TaskBatchSize", 1);
+    if (batchSize < 1)
+    {
+        Warning out(m_logger);
+        out << m_poolname << ".TaskBatchSize < 1; TaskBatchSize adjusted to 1";
+        batchSize = 1;
+    }
+    const_cast<size_t&>(m_batchsize) = static_cast<size_t>(batchSize);
+
+    //
+    // Affinity pins the workers to the CPUs of CpuList, all the CPUs the
+    // process may use by default: compact takes the CPUs in order, scatter
+    // spreads the workers over the NUMA nodes first and numa pins every
+    // worker to all the CPUs of a node, round robin.
+    //
+    std::string affinity = Threading::ToLower(m_properties->GetProperty(m_poolname + ".Affinity"));
+    std::string cpulist = m_properties->GetProperty(m_poolname + ".CpuList");
+    if (affinity.empty() && !cpulist.empty())
+    {
+        affinity = "compact";
+    }
+
+    if (!affinity.empty() && "none" != affinity)
+    {
+        CpuSet cpus = CpuSet::Available();
+        if (!cpulist.empty())
+        {
+            CpuSet usable;
+            try
+            {
+                std::vector<size_t> listed = CpuSet(cpulist).Cpus();
+                for (size_t i = 0; i < listed.size(); ++i)
+                {
+                    if (cpus.IsSet(listed[i]))
+                    {
+                        usable.Set(listed[i]);
+                    }
+                }
+            }
+            catch (const IllegalArgumentException&)
+            {
+            }
+
+            if (usable.Empty())
+            {
+                Warning out(m_logger);
+                out << m_poolname << ".CpuList `" << cpulist << "' has no available CPU; CpuList adjusted to " << cpus.ToString();
+            }
+            else
+            {
+                cpus = usable;
+            }
+        }
+
+        std::vector<size_t> list = cpus.Cpus();
+        std::map<int, std::vector<size_t> > nodes;
+        for (size_t i = 0; i < list.size(); ++i)
+        {
+            nodes[CpuSet::NumaNode(list[i])].push_back(list[i]);
+        }
+
+        if ("compact" == affinity || "scatter" == affinity)
+        {
+            for (size_t round = 0; m_workercpus.size() < list.size(); ++round)
+            {
+                for (std::map<int, std::vector<size_t> >::const_iterator iter = nodes.begin(); iter != nodes.end(); ++iter)
+                {
+                    if ("scatter" == affinity && round < iter->second.size())
+                    {
+                        m_workercpus.push_back(CpuSet());
+                        m_workercpus.back().Set(iter->second[round]);
+                    }
+                }
+
+                if ("compact" == affinity)
+                {
+                    m_workercpus.push_back(CpuSet());
+                    m_workercpus.back().Set(list[round]);
+                }
+            }
+        }
+        else if ("numa" == affinity)
+        {
+            for (std::map<int, std::vector<size_t> >::const_iterator iter = nodes.begin(); iter != nodes.end(); ++iter)
+            {
+                m_workercpus.push_back(CpuSet());
+                for (size_t i = 0; i < iter->second.size(); ++i)
+                {
+                    m_workercpus.back().Set(iter->second[i]);
+                }
+            }
+        }
+        else
+        {
+            Warning out(m_logger);
+            out << m_poolname << ".Affinity `" << affinity << "' is unknown; Affinity adjusted to None";
+        }
+    }
+
+    std::string scheduler = Threading::ToLower(m_properties->GetProperty(m_poolname + ".Scheduler"));
+    if ("workstealing" == scheduler)
+    {
+        //
+        // Pinned workers allocate their own deque, so that its memory is
+        // first touched, and placed, on their NUMA node.
+        //
+        const_cast<bool&>(m_workstealing) = true;
+        for (size_t i = 0; i < m_sizemax; ++i)
+        {
+            m_localqueues.push_back(m_workercpus.empty() ? new WorkStealingQueue<TaskBase>() : 0);
+        }
+    }
+    else if (!scheduler.empty() && "fifo" != scheduler)
+    {
+        Warning out(m_logger);
+        out << m_poolname << ".Scheduler `" << scheduler << "' is unknown; Scheduler adjusted to Fifo";
+    }
+
     /// pre-create threads.
     try
     {
         for (size_t i = 0; i < m_size; ++i)
         {
-            m_threads.insert(new TaskThread(*this));
+            m_threads.insert(new TaskThread(*this, nextWorkerIndex()));
         }
     }
     catch(const Threading::Exception& ex)
@@ -172,6 +756,8 @@ Threading::ThreadPool::ThreadPool(const std::string& properties_file,
         }
         throw;
     }
+
+    startShrinker();
 }
 
 Threading::ThreadPool::~ThreadPool(void)
@@ -181,6 +767,11 @@ Threading::ThreadPool::~ThreadPool(void)
     JoinAll();
 
     assert(0 == m_inuse);
+
+    for (size_t i = 0; i < m_localqueues.size(); ++i)
+    {
+        delete m_localqueues[i];
+    }
 }
 
 void Threading::ThreadPool::Reset()
@@ -192,7 +783,7 @@ void Threading::ThreadPool::Reset()
     {
         for (size_t i = 0; i < m_size; ++i)
         {
-            m_threads.insert(new TaskThread(*this));
+            m_threads.insert(new TaskThread(*this, nextWorkerIndex()));
         }
     }
     catch(const Threading::Exception& ex)
@@ -204,80 +795,245 @@ void Threading::ThreadPool::Reset()
         }
         throw;
     }
+
+    startShrinker();
 }
 
 void Threading::ThreadPool::SubmitTask(const TaskPtr& task)
 {
-    if (m_destroyed)
+    checkDestroyed();
+
+    if (!task)
     {
-        Error out(m_logger);
-        out << "cannot submit task to the destroyed ThreadPool: `" << m_poolname << "'\n"
-            << "please reset this pool, or create a new thread pool.";
-        
-        throw ThreadPoolDestroyedException(__FILE__, __LINE__);
+        return;
     }
 
-    if (!task)
+    //
+    // A task spawned by a worker of a work-stealing pool stays on that
+    // worker's own deque unless some worker is blocked waiting for work,
+    // in which case it goes through the global queue to wake it up.
+    //
+    int index = m_workstealing ? m_workerindex.Get() : -1;
+    if (index >= 0 && 0 == m_idlethreads)
     {
+        m_localqueues[index]->Push(task);
+    }
+    else if (pushTask(task, -1))
+    {
+        wakeWorkers(1);
+    }
+    else
+    {
+        runInline(task);
         return;
     }
 
-    m_tasksqueue.Push(task);
+    tasksSubmitted(1);
+}
+
+void Threading::ThreadPool::SubmitTasks(const std::vector<TaskPtr>& tasks)
+{
+    checkDestroyed();
 
+    // Null tasks are skipped, as by SubmitTask; copy only if there are any.
+    const std::vector<TaskPtr>* batch = &tasks;
+    std::vector<TaskPtr> nonnull;
+    for (std::vector<TaskPtr>::const_iterator iter = tasks.begin(); iter != tasks.end(); ++iter)
     {
-        LockGuard sync(*this);
-        size_t inuse = ++m_inuse;
-        if (inuse >= m_sizemax || inuse < m_size)
+        if (!*iter && batch == &tasks)
         {
-            return;
+            nonnull.assign(tasks.begin(), iter);
+            batch = &nonnull;
         }
-
-        if (inuse == m_sizewarn)
+        else if (*iter && batch == &nonnull)
         {
-            Warning out(m_logger);
-            out << "thread pool `" << m_poolname << "' is running low on threads\n"
-                << "Size=" << m_size << ", " << "SizeMax=" << m_sizemax << ", " << "SizeWarn=" << m_sizewarn;
+            nonnull.push_back(*iter);
         }
+    }
 
-        assert(inuse <= m_threads.size());
-        if (inuse <= m_sizemax && inuse == m_threads.size())
+    if (batch->empty())
+    {
+        return;
+    }
+
+    int index = m_workstealing ? m_workerindex.Get() : -1;
+    if (index >= 0 && 0 == m_idlethreads)
+    {
+        m_localqueues[index]->PushBatch(batch->begin(), batch->end());
+    }
+    else if (m_boundedqueue && m_workerindex.Get() >= 0)
+    {
+        // One at a time, so that those the ring has no room for run here.
+        for (std::vector<TaskPtr>::const_iterator iter = batch->begin(); iter != batch->end(); ++iter)
         {
-            {
-                Trace out(m_logger, "");
-                out << "growing " << m_poolname << ": Size=" << m_threads.size() + 1;
-            }
+            SubmitTask(*iter);
+        }
+        return;
+    }
+    else
+    {
+        m_tasksqueue->PushBatch(*batch);
+        wakeWorkers(batch->size());
+    }
 
-            try
-            {
-                m_threads.insert(new TaskThread(*this));
-            }
-            catch(const Threading::Exception& ex)
-            {
-                m_destroyed = true;     
-                {
-                    Error out(m_logger);
-                    out << "cannot create thread for `" << m_poolname << "':\n" << ex;
-                }
-                throw;
-            }
+    tasksSubmitted(batch->size());
+}
+
+void Threading::ThreadPool::SubmitTask(const TaskPtr& task, int priority)
+{
+    checkDestroyed();
+
+    if (!task)
+    {
+        return;
+    }
+
+    if (!pushTask(task, m_lanequeue ? (priority > 0 ? priority : 0) : -1))
+    {
+        runInline(task);
+        return;
+    }
+    wakeWorkers(1);
+
+    tasksSubmitted(1);
+}
+
+//
+// Pushes task to the global queue, to lane unless it is -1. A worker does
+// not wait for room in a full ring, where it could wait for itself: it
+// returns false instead, and the caller runs the task.
+//
+bool Threading::ThreadPool::pushTask(const TaskPtr& task, int lane)
+{
+    if (!m_boundedqueue || m_workerindex.Get() < 0)
+    {
+        if (lane < 0)
+        {
+            m_tasksqueue->Push(task);
+        }
+        else
+        {
+            m_lanequeue->Push(task, static_cast<size_t>(lane));
         }
+        return true;
+    }
+
+    return lane < 0 ? m_tasksqueue->TryPush(task) : m_lanequeue->TryPush(task, static_cast<size_t>(lane));
+}
+
+//
+// Runs task on the calling worker, as the worker runs the tasks it pops.
+//
+void Threading::ThreadPool::runInline(const TaskPtr& task)
+{
+    try
+    {
+        task->Run();
+        task->NotifyDone();
+    }
+    catch (...)
+    {
+        task->NotifyDone();
+        taskFailed(typeid(task).name());
     }
 }
 
 Threading::TaskPtr Threading::ThreadPool::SubmitTask(void (*fun)(void *), void *param)
 {
-    TaskPtr task(new CallbackTask(fun, param));
+    TaskPtr task(new SmallTask(fun, param));
 
     SubmitTask(task);
 
     return task;
 }
 
+void Threading::ThreadPool::checkDestroyed()
+{
+    if (m_destroyed)
+    {
+        if (LogRateLimited(m_destroyedlog, ErrorRate, ErrorBurst))
+        {
+            Error out(m_logger);
+            out << TakeSuppressed(m_destroyedlog)
+                << "cannot submit task to the destroyed ThreadPool: `" << m_poolname << "'\n"
+                << "please reset this pool, or create a new thread pool.";
+        }
+        
+        throw ThreadPoolDestroyedException(__FILE__, __LINE__);
+    }
+}
+
+//
+// Accounts for count newly queued tasks and grows the pool if they may
+// find all the threads busy. The pool's lock is only taken when the pool
+// can grow and the pre-created threads may all be in use.
+//
+void Threading::ThreadPool::tasksSubmitted(size_t count)
+{
+    const int inuse = (m_inuse += static_cast<int>(count));
+    const int previous = inuse - static_cast<int>(count);
+
+    if (0 != m_sizewarn && previous < static_cast<int>(m_sizewarn) && inuse >= static_cast<int>(m_sizewarn) &&
+        LogEveryT(m_lowthreadslog, LowThreadsInterval))
+    {
+        Warning out(m_logger);
+        out << TakeSuppressed(m_lowthreadslog)
+            << "thread pool `" << m_poolname << "' is running low on threads\n"
+            << "Size=" << m_size << ", " << "SizeMax=" << m_sizemax << ", " << "SizeWarn=" << m_sizewarn;
+    }
+
+    if (m_size == m_sizemax || inuse < static_cast<int>(m_size))
+    {
+        return;
+    }
+
+    LockGuard sync(*this);
+    while (m_threads.size() < m_sizemax && static_cast<int>(m_threads.size()) <= inuse)
+    {
+        {
+            Trace out(m_logger, "");
+            out << "growing " << m_poolname << ": Size=" << m_threads.size() + 1;
+        }
+
+        try
+        {
+            m_threads.insert(new TaskThread(*this, nextWorkerIndex()));
+        }
+        catch(const Threading::Exception& ex)
+        {
+            m_destroyed = true;     
+            {
+                Error out(m_logger);
+                out << "cannot create thread for `" << m_poolname << "':\n" << ex;
+            }
+            throw;
+        }
+    }
+}
+
+void Threading::ThreadPool::taskFailed(const char* type)
+{
+    if (LogRateLimited(m_taskerrorlog, ErrorRate, ErrorBurst))
+    {
+        Error out(m_logger);
+        out << TakeSuppressed(m_taskerrorlog)
+            << "task: " << type << " in thread pool `" << m_poolname << "' is running error, "
+            << "please check the thask's Run() method\n";
+    }
+}
+
 void Threading::ThreadPool::JoinAll()
 {
-    while (!m_tasksqueue.Empty()) {};
+    if (m_shrinktimer)
+    {
+        m_shrinktimer->Destroy();
+        m_shrinktimer = 0;
+    }
+
+    while (tasksPending()) {};
 
     m_destroyed = true;
+    wakeWorkers(m_threads.size());
 
     size_t joinedsize = m_threads.size();
     std::set<ThreadPtr>::const_iterator iter = m_threads.begin(); 
@@ -286,6 +1042,7 @@ void Threading::ThreadPool::JoinAll()
         ThreadJoiner(*iter);
         m_threads.erase(iter++);
     }
+    m_freeindexes.clear();
 
     {
         Trace out(m_logger, "");
@@ -293,9 +1050,212 @@ void Threading::ThreadPool::JoinAll()
     }
 }
 
+Threading::TaskPtr Threading::ThreadPool::stealTask(size_t thief)
+{
+    size_t count = m_localqueues.size();
+    for (size_t i = 1; i < count; ++i)
+    {
+        WorkStealingQueue<TaskBase>* victim = AtomicLoad(&m_localqueues[(thief + i) % count], MemoryOrderAcquire);
+        TaskPtr task = victim ? victim->TrySteal() : TaskPtr();
+        if (task)
+        {
+            return task;
+        }
+    }
+
+    return TaskPtr();
+}
+
+Threading::CpuSet Threading::ThreadPool::workerCpus(size_t index) const
+{
+    return m_workercpus.empty() ? CpuSet() : m_workercpus[index % m_workercpus.size()];
+}
+
+//
+// Called by the worker owning the deque, which allocates it on first use.
+// The slot is read with acquire, as by the thieves, so that a deque is
+// never seen before it is fully constructed.
+//
+Threading::WorkStealingQueue<Threading::TaskBase>* Threading::ThreadPool::localQueue(size_t index)
+{
+    WorkStealingQueue<TaskBase>* queue = AtomicLoad(&m_localqueues[index], MemoryOrderAcquire);
+    if (queue)
+    {
+        return queue;
+    }
+
+    queue = new WorkStealingQueue<TaskBase>();
+    WorkStealingQueue<TaskBase>* current = 0;
+    if (!AtomicCompareExchange(&m_localqueues[index], current, queue))
+    {
+        delete queue;
+        return current;
+    }
+    return queue;
+}
+
+void Threading::ThreadPool::parkWorker(TaskThread* worker)
+{
+    Threading::Mutex::LockGuard sync(m_parkedmutex);
+    m_parked.push_back(worker);
+    ++m_idlethreads;
+}
+
+bool Threading::ThreadPool::unparkWorker(TaskThread* worker)
+{
+    Threading::Mutex::LockGuard sync(m_parkedmutex);
+    std::vector<TaskThread*>::iterator iter = std::find(m_parked.begin(), m_parked.end(), worker);
+    if (iter == m_parked.end())
+    {
+        return false;       // already woken
+    }
+    m_parked.erase(iter);
+    --m_idlethreads;
+    return true;
+}
+
+//
+// Wakes up to count parked threads, the most recently parked first since
+// its cache is the warmest.
+//
+void Threading::ThreadPool::wakeWorkers(size_t count)
+{
+    while (count-- > 0 && 0 != m_idlethreads)
+    {
+        TaskThread* worker = 0;
+        {
+            Threading::Mutex::LockGuard sync(m_parkedmutex);
+            if (m_parked.empty())
+            {
+                return;
+            }
+            worker = m_parked.back();
+            m_parked.pop_back();
+            --m_idlethreads;
+        }
+        worker->m_parking.Notify();
+    }
+}
+
+bool Threading::ThreadPool::tasksPending()
+{
+    if (!m_tasksqueue->Empty())
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < m_localqueues.size(); ++i)
+    {
+        WorkStealingQueue<TaskBase>* queue = AtomicLoad(&m_localqueues[i], MemoryOrderAcquire);
+        if (queue && !queue->Empty())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t Threading::ThreadPool::nextWorkerIndex()
+{
+    if (m_freeindexes.empty())
+    {
+        return m_threads.size();
+    }
+
+    size_t index = m_freeindexes.back();
+    m_freeindexes.pop_back();
+    return index;
+}
+
+void Threading::ThreadPool::startShrinker()
+{
+    if (0 == m_shrinkcycletime || m_size == m_sizemax || m_shrinktimer)
+    {
+        return;
+    }
+
+    m_shrinktimer = new Timer();
+    m_shrinktimer->ScheduleRepeated(new IdleThreadShrinker(*this), Time::Seconds(m_shrinkcycletime));
+}
+
+void Threading::ThreadPool::shrink()
+{
+    // The pool is locked while it grows or is destroyed; try next cycle.
+    TryLockGuard sync(*this);
+    if (!sync.Acquired() || m_destroyed || m_threads.size() <= m_size)
+    {
+        return;
+    }
+
+    const Time idletime = m_threadidletime > 0 ? 
+        Time::MilliSeconds(m_threadidletime) : Time::Seconds(m_shrinkcycletime);
+    const Time now = Time::Now(Time::Monotonic);
+
+    //
+    // Only parked workers are retired. Taking them off the parked list
+    // means no submitter wakes them for a task, so they exit as soon as
+    // they see m_destroyed and the join below doesn't wait for any task.
+    //
+    std::vector<TaskThread*> retired;
+    {
+        Threading::Mutex::LockGuard parked(m_parkedmutex);
+        std::vector<TaskThread*>::iterator iter = m_parked.begin();     // the least recently parked first
+        while (iter != m_parked.end() && m_threads.size() - retired.size() > m_size)
+        {
+            if (now - (*iter)->m_idlesince < idletime)
+            {
+                ++iter;
+                continue;
+            }
+
+            (*iter)->m_destroyed = true;
+            retired.push_back(*iter);
+            iter = m_parked.erase(iter);
+            --m_idlethreads;
+        }
+    }
+
+    if (retired.empty())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < retired.size(); ++i)
+    {
+        retired[i]->m_parking.Notify();
+    }
+
+    for (size_t i = 0; i < retired.size(); ++i)
+    {
+        ThreadPtr thread = retired[i];
+        ThreadJoiner(thread);
+        m_freeindexes.push_back(retired[i]->m_index);
+        m_threads.erase(thread);
+    }
+
+    {
+        Trace out(m_logger, "");
+        out << "shrinking " << m_poolname << ": Size=" << m_threads.size() 
+            << " (" << retired.size() << " idle threads retired)";
+    }
+}
+
+std::vector<size_t> Threading::ThreadPool::GetLaneDepths() const
+{
+    std::vector<size_t> depths;
+    if (m_lanequeue)
+    {
+        for (size_t lane = 0; lane < m_lanequeue->Lanes(); ++lane)
+        {
+            depths.push_back(m_lanequeue->Depth(lane));
+        }
+    }
+    return depths;
+}
+
 void Threading::ThreadPool::SetThreadIdleTime(const Time& idle_time)
 {
-    const_cast<bool&>(m_waitifnotask) = true;
     Threading::Int64 threadIdleTime = idle_time.ToMilliSeconds();
     if (threadIdleTime < 0)
     {
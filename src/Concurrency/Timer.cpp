@@ -8,28 +8,457 @@
 
 #include <Concurrency/Timer.h>
 #include <Concurrency/ThreadException.h>
+#include <Concurrency/ThreadPool.h>
+#include <Logging/LogRateLimit.h>
+
+#if defined(LANG_CPP11)
+#   include <unordered_map>
+#   define TIMER_HASH_MAP std::unordered_map
+#elif defined(_WIN32)
+#   include <unordered_map>
+#   define TIMER_HASH_MAP std::tr1::unordered_map
+#else
+#   include <tr1/unordered_map>
+#   define TIMER_HASH_MAP std::tr1::unordered_map
+#endif
 
 using namespace std;
 
 THREADING_BEGIN
 
-Timer::Timer(void) : Thread("Util timer thread"), m_destroyed(false)
+//
+// Only used under the monitor of its Timer.
+//
+class TimerQueue
+{
+public:
+    virtual ~TimerQueue() {}
+
+    // Returns false if the task is already scheduled.
+    virtual bool Insert(const ScheduleTask& scheduleTask) = 0;
+
+    virtual bool Erase(const TimerTaskPtr& task) = 0;
+
+    // Moves a scheduled task, returns false if it is not scheduled.
+    virtual bool Reschedule(const TimerTaskPtr& task, const Time& scheduledtime) = 0;
+
+    virtual bool Empty() const = 0;
+
+    virtual void Clear() = 0;
+
+    // Removes a task due at now, returns false if there is none.
+    virtual bool PopExpired(const Time& now, ScheduleTask& scheduleTask) = 0;
+
+    // When to look for expired tasks again, called after PopExpired failed.
+    virtual Time NextExpiry() const = 0;
+};
+
+namespace
+{
+
+class SetTimerQueue : public TimerQueue
+{
+public:
+
+    virtual bool Insert(const ScheduleTask& scheduleTask)
+    {
+        bool inserted = m_alltasks.insert(std::make_pair(scheduleTask.m_task, scheduleTask.m_scheduledtime)).second;
+        if (inserted)
+        {
+            m_scheduleTasks.insert(scheduleTask);
+        }
+        return inserted;
+    }
+
+    virtual bool Erase(const TimerTaskPtr& task)
+    {
+        std::map<TimerTaskPtr, Time, TimerTaskCompare>::iterator iter = m_alltasks.find(task);
+        if (iter == m_alltasks.end())
+        {
+            return false;
+        }
+
+        m_scheduleTasks.erase(ScheduleTask(task, iter->second, Time()));
+        m_alltasks.erase(iter);
+        return true;
+    }
+
+    virtual bool Reschedule(const TimerTaskPtr& task, const Time& scheduledtime)
+    {
+        std::map<TimerTaskPtr, Time, TimerTaskCompare>::iterator iter = m_alltasks.find(task);
+        if (iter == m_alltasks.end())
+        {
+            return false;
+        }
+
+        std::set<ScheduleTask>::iterator scheduled = m_scheduleTasks.find(ScheduleTask(task, iter->second, Time()));
+        ScheduleTask scheduleTask = *scheduled;
+        m_scheduleTasks.erase(scheduled);
+        scheduleTask.m_scheduledtime = iter->second = scheduledtime;
+        m_scheduleTasks.insert(scheduleTask);
+        return true;
+    }
+
+    virtual bool Empty() const
+    {
+        return m_scheduleTasks.empty();
+    }
+
+    virtual void Clear()
+    {
+        m_alltasks.clear();
+        m_scheduleTasks.clear();
+    }
+
+    virtual bool PopExpired(const Time& now, ScheduleTask& scheduleTask)
+    {
+        if (m_scheduleTasks.empty() || m_scheduleTasks.begin()->m_scheduledtime > now)
+        {
+            return false;
+        }
+
+        scheduleTask = *m_scheduleTasks.begin();
+        m_scheduleTasks.erase(m_scheduleTasks.begin());
+        m_alltasks.erase(scheduleTask.m_task);
+        return true;
+    }
+
+    virtual Time NextExpiry() const
+    {
+        return m_scheduleTasks.begin()->m_scheduledtime;
+    }
+
+private:
+
+    std::set<ScheduleTask>    m_scheduleTasks;
+
+    std::map<TimerTaskPtr, Time, TimerTaskCompare> m_alltasks;
+};
+
+//
+// Hierarchical timing wheel: Levels wheels of Slots slots, a slot of level
+// n spanning Slots^n ticks. A task goes to the lowest level whose span
+// covers its delay and moves down a level (cascades) when the slot it is
+// in comes round, until it expires from level 0. Delays beyond the top
+// level are parked in its farthest slot and placed again from there.
+//
+// Tasks are indexed by a hash table, so that Cancel is O(1) as well.
+//
+class WheelTimerQueue : public TimerQueue
+{
+public:
+
+    WheelTimerQueue(const Time& tick) :
+        m_tick(tick.ToMicroSeconds()),
+        m_origin(Time::Now(Time::Monotonic)),
+        m_current(0)
+    {
+        if (m_tick <= 0)
+        {
+            throw IllegalArgumentException(__FILE__, __LINE__, "invalid timer tick");
+        }
+
+        Clear();
+    }
+
+    virtual bool Insert(const ScheduleTask& scheduleTask)
+    {
+        std::pair<Entries::iterator, bool> result =
+            m_entries.insert(std::make_pair(scheduleTask.m_task.Get(), Entry()));
+        if (!result.second)
+        {
+            return false;
+        }
+
+        Entry& entry = result.first->second;
+        entry.m_task = scheduleTask;
+        entry.m_tick = tickOf(scheduleTask.m_scheduledtime);
+        place(entry);
+        return true;
+    }
+
+    virtual bool Erase(const TimerTaskPtr& task)
+    {
+        Entries::iterator iter = m_entries.find(task.Get());
+        if (iter == m_entries.end())
+        {
+            return false;
+        }
+
+        //
+        // Erase by key: erasing by iterator looks for the next element,
+        // which is slow with sparse buckets.
+        //
+        unlink(iter->second);
+        m_entries.erase(task.Get());
+        return true;
+    }
+
+    virtual bool Reschedule(const TimerTaskPtr& task, const Time& scheduledtime)
+    {
+        Entries::iterator iter = m_entries.find(task.Get());
+        if (iter == m_entries.end())
+        {
+            return false;
+        }
+
+        Entry& entry = iter->second;
+        unlink(entry);
+        entry.m_task.m_scheduledtime = scheduledtime;
+        entry.m_tick = tickOf(scheduledtime);
+        place(entry);
+        return true;
+    }
+
+    virtual bool Empty() const
+    {
+        return m_entries.empty();
+    }
+
+    virtual void Clear()
+    {
+        m_entries.clear();
+        for (int level = 0; level < Levels; ++level)
+        {
+            for (int slot = 0; slot < Slots; ++slot)
+            {
+                m_slots[level][slot].m_prev = m_slots[level][slot].m_next = &m_slots[level][slot];
+            }
+            m_counts[level] = 0;
+        }
+        m_ready.m_prev = m_ready.m_next = &m_ready;
+        m_counts[Levels] = 0;
+    }
+
+    virtual bool PopExpired(const Time& now, ScheduleTask& scheduleTask)
+    {
+        if (m_ready.m_next == &m_ready)
+        {
+            advance(now);
+            if (m_ready.m_next == &m_ready)
+            {
+                return false;
+            }
+        }
+
+        Entry* entry = static_cast<Entry*>(m_ready.m_next);
+        scheduleTask = entry->m_task;
+        unlink(*entry);
+        m_entries.erase(scheduleTask.m_task.Get());
+        return true;
+    }
+
+    //
+    // The tick of the first occupied slot, at level 0, or of the first
+    // slot due to cascade, at the upper levels.
+    //
+    virtual Time NextExpiry() const
+    {
+        Int64 next = -1;
+        for (int level = 0; level < Levels; ++level)
+        {
+            if (0 == m_counts[level])
+            {
+                continue;
+            }
+
+            int shift = SlotBits * level;
+            Int64 base = m_current >> shift;
+            for (Int64 index = (0 == level ? 0 : 1); index <= Slots; ++index)
+            {
+                if (!empty(m_slots[level][(base + index) & SlotMask]))
+                {
+                    Int64 tick = (base + index) << shift;
+                    if (next < 0 || tick < next)
+                    {
+                        next = tick;
+                    }
+                    break;
+                }
+            }
+        }
+
+        return next < 0 ? m_origin : m_origin + Time::MicroSeconds(next * m_tick);
+    }
+
+private:
+
+    enum
+    {
+        SlotBits = 8,
+        Slots = 1 << SlotBits,
+        SlotMask = Slots - 1,
+        Levels = 4
+    };
+
+    struct Link
+    {
+        Link* m_prev;
+        Link* m_next;
+    };
+
+    struct Entry : public Link
+    {
+        ScheduleTask m_task;
+        Int64 m_tick;
+        int m_level;        // Levels for m_ready.
+    };
+
+    typedef TIMER_HASH_MAP<TimerTask*, Entry> Entries;
+
+    static bool empty(const Link& slot)
+    {
+        return slot.m_next == &slot;
+    }
+
+    // Expiry rounded up to a tick, so that no task runs early.
+    Int64 tickOf(const Time& time) const
+    {
+        Int64 elapsed = (time - m_origin).ToMicroSeconds();
+        return elapsed > 0 ? (elapsed + m_tick - 1) / m_tick : 0;
+    }
+
+    void link(Entry& entry, Link& slot, int level)
+    {
+        entry.m_prev = slot.m_prev;
+        entry.m_next = &slot;
+        slot.m_prev->m_next = &entry;
+        slot.m_prev = &entry;
+        entry.m_level = level;
+        ++m_counts[level];
+    }
+
+    void unlink(Entry& entry)
+    {
+        entry.m_prev->m_next = entry.m_next;
+        entry.m_next->m_prev = entry.m_prev;
+        --m_counts[entry.m_level];
+    }
+
+    void place(Entry& entry)
+    {
+        Int64 tick = entry.m_tick > m_current ? entry.m_tick : m_current;
+        Int64 delta = tick - m_current;
+
+        int level = 0;
+        while (level < Levels - 1 && delta >= (static_cast<Int64>(1) << (SlotBits * (level + 1))))
+        {
+            ++level;
+        }
+
+        Int64 span = static_cast<Int64>(1) << (SlotBits * Levels);
+        if (delta >= span)
+        {
+            tick = m_current + span - 1;
+        }
+
+        link(entry, m_slots[level][(tick >> (SlotBits * level)) & SlotMask], level);
+    }
+
+    void advance(const Time& now)
+    {
+        Int64 elapsed = (now - m_origin).ToMicroSeconds();
+        if (elapsed < 0)
+        {
+            return;
+        }
+
+        Int64 target = elapsed / m_tick;
+        if (m_entries.size() == static_cast<size_t>(m_counts[Levels]))
+        {
+            m_current = target + 1 > m_current ? target + 1 : m_current;
+            return;
+        }
+
+        while (m_current <= target)
+        {
+            if (0 == m_counts[0])
+            {
+                // Nothing to expire before the next cascade.
+                Int64 cascade = (m_current | SlotMask) + 1;
+                m_current = target + 1 < cascade ? target + 1 : cascade;
+            }
+            else
+            {
+                Link& slot = m_slots[0][m_current & SlotMask];
+                while (!empty(slot))
+                {
+                    Entry* entry = static_cast<Entry*>(slot.m_next);
+                    unlink(*entry);
+                    link(*entry, m_ready, Levels);
+                }
+                ++m_current;
+            }
+
+            for (int level = 1; level < Levels && 0 == (m_current & ((static_cast<Int64>(1) << (SlotBits * level)) - 1)); ++level)
+            {
+                Link& slot = m_slots[level][(m_current >> (SlotBits * level)) & SlotMask];
+                while (!empty(slot))
+                {
+                    Entry* entry = static_cast<Entry*>(slot.m_next);
+                    unlink(*entry);
+                    place(*entry);
+                }
+            }
+        }
+    }
+
+    const Int64 m_tick;             // In microseconds.
+    const Time m_origin;            // Time of tick 0.
+    Int64 m_current;                // Next tick to expire.
+    Link m_slots[Levels][Slots];
+    Link m_ready;                   // Expired, not yet popped.
+    int m_counts[Levels + 1];       // Tasks per level, m_ready last.
+    Entries m_entries;
+};
+
+}
+
+Timer::Timer(void) : Thread("Util timer thread"), m_destroyed(false), m_queue(new SetTimerQueue())
 {
     SetNoDelete(true);
     Start();
     SetNoDelete(false);
 }
 
-Timer::Timer(int priority) : Thread("Util timer thread"), m_destroyed(false)
+Timer::Timer(int priority) : Thread("Util timer thread"), m_destroyed(false), m_queue(new SetTimerQueue())
 {
     SetNoDelete(true);
     Start(0, priority);
     SetNoDelete(false);
 }
 
+Timer::Timer(const Time& tick) : Thread("Util timer thread"), m_destroyed(false), m_queue(new WheelTimerQueue(tick))
+{
+    SetNoDelete(true);
+    Start();
+    SetNoDelete(false);
+}
+
+Timer::Timer(const Time& tick, int priority) : Thread("Util timer thread"), m_destroyed(false), m_queue(new WheelTimerQueue(tick))
+{
+    SetNoDelete(true);
+    Start(0, priority);
+    SetNoDelete(false);
+}
+
+Timer::Timer(const ThreadPoolPtr& pool, const Time& tick) : Thread("Util timer thread"), m_destroyed(false),
+    m_queue(Time() == tick ? static_cast<TimerQueue*>(new SetTimerQueue()) : new WheelTimerQueue(tick)),
+    m_pool(pool)
+{
+    if (!m_pool)
+    {
+        throw IllegalArgumentException(__FILE__, __LINE__, "null thread pool");
+    }
+
+    SetNoDelete(true);
+    Start();
+    SetNoDelete(false);
+}
+
 Timer::~Timer()
 {
-    Destroy();        
+    Destroy();
 }
 
 void Timer::Destroy()
@@ -42,8 +471,8 @@ void Timer::Destroy()
         }
         m_destroyed = true;
         m_monitor.Notify();
-        m_alltasks.clear();
-        m_scheduleTasks.clear();
+        m_queue->Clear();
+        m_running.clear();
     }
 
     if (GetThreadControl() == ThreadControl())
@@ -56,6 +485,13 @@ void Timer::Destroy()
     }
 }
 
+void Timer::SetSlack(const Time& slack)
+{
+    Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+    m_slack = slack > Time() ? slack : Time();
+    m_monitor.Notify();
+}
+
 void Timer::Schedule(const TimerTaskPtr& task, const Time& delaytime)
 {
     Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
@@ -71,21 +507,27 @@ void Timer::Schedule(const TimerTaskPtr& task, const Time& delaytime)
         throw IllegalArgumentException(__FILE__, __LINE__, "invalid delay");
     }
 
-    bool inserted = m_alltasks.insert(std::make_pair(task, scheduleTime)).second;
-    if (!inserted)
+    insert(ScheduleTask(task, scheduleTime));
+}
+
+void Timer::ScheduleRepeated(const TimerTaskPtr& task, const Time& delaytime, const Time& basetime)
+{
+    Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+    if (m_destroyed)
     {
-        throw IllegalArgumentException(__FILE__, __LINE__, "task is already schedulded");
+        throw IllegalArgumentException(__FILE__, __LINE__, "timer destroyed");
     }
 
-    m_scheduleTasks.insert(ScheduleTask(task, scheduleTime));
-
-    if (m_taskWakeUpTime == Time() || scheduleTime < m_taskWakeUpTime)
+    Time scheduleTime = basetime + delaytime;
+    if (delaytime > Time() && scheduleTime < basetime)
     {
-        m_monitor.Notify();
+        throw IllegalArgumentException(__FILE__, __LINE__, "invalid delay");
     }
+
+    insert(ScheduleTask(task, scheduleTime, delaytime));
 }
 
-void Timer::ScheduleRepeated(const TimerTaskPtr& task, const Time& delaytime, const Time& basetime)
+void Timer::ScheduleAtFixedRate(const TimerTaskPtr& task, const Time& period, const Time& basetime)
 {
     Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
     if (m_destroyed)
@@ -93,24 +535,44 @@ void Timer::ScheduleRepeated(const TimerTaskPtr& task, const Time& delaytime, co
         throw IllegalArgumentException(__FILE__, __LINE__, "timer destroyed");
     }
 
-    Time scheduleTime = basetime + delaytime;
-    if (delaytime > Time() && scheduleTime < basetime)
+    Time scheduleTime = basetime + period;
+    if (period <= Time() || scheduleTime < basetime)
     {
-        throw IllegalArgumentException(__FILE__, __LINE__, "invalid delay");
+        throw IllegalArgumentException(__FILE__, __LINE__, "invalid period");
+    }
+
+    insert(ScheduleTask(task, scheduleTime, period, true));
+}
+
+bool Timer::Reschedule(const TimerTaskPtr& task, const Time& delaytime)
+{
+    Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+    if (m_destroyed)
+    {
+        return false;
     }
 
-    bool inserted = m_alltasks.insert(std::make_pair(task, scheduleTime)).second;
-    if (!inserted)
+    Time now = Time::Now(Time::Monotonic);
+    Time scheduleTime = now + delaytime;
+    if (delaytime > Time() && scheduleTime < now)
     {
-        throw IllegalArgumentException(__FILE__, __LINE__, "task is already schedulded");
+        throw IllegalArgumentException(__FILE__, __LINE__, "invalid delay");
     }
 
-    m_scheduleTasks.insert(ScheduleTask(task, scheduleTime, delaytime));
+    std::map<TimerTaskPtr, Time, TimerTaskCompare>::iterator running = m_running.find(task);
+    if (running != m_running.end())
+    {
+        running->second = scheduleTime;
+        return true;
+    }
 
-    if (m_taskWakeUpTime == Time() || scheduleTime < m_taskWakeUpTime)
+    if (!m_queue->Reschedule(task, scheduleTime))
     {
-        m_monitor.Notify();
+        return false;
     }
+
+    wakeUp(scheduleTime);
+    return true;
 }
 
 bool Timer::Cancel(const TimerTaskPtr& task)
@@ -121,125 +583,109 @@ bool Timer::Cancel(const TimerTaskPtr& task)
         return false;
     }
 
-    std::map<TimerTaskPtr, Time, TimerTaskCompare>::iterator iter = m_alltasks.find(task);
-    if (iter == m_alltasks.end())
+    return 0 != m_running.erase(task) || m_queue->Erase(task);
+}
+
+//
+// Runs a task handed over to a ThreadPool.
+//
+class TimerDispatchTask : public TaskBase
+{
+public:
+
+    TimerDispatchTask(Timer& timer, const ScheduleTask& scheduleTask) :
+        TaskBase("timer task"), m_timer(&timer), m_scheduleTask(scheduleTask)
+    {
+    }
+
+    virtual void Run()
     {
-        return false;
+        m_timer->runTask(m_scheduleTask);
     }
 
-    m_scheduleTasks.erase(ScheduleTask(task, iter->second, Time()));
-    m_alltasks.erase(iter);
+private:
 
-    return true;
-}
+    TimerPtr m_timer;
+
+    ScheduleTask m_scheduleTask;
+};
 
 void Timer::Run()
 {
-    ScheduleTask scheduleTask;
+    std::vector<ScheduleTask> expired;
 
     while (true)
     {
-        //Time repeateBaseTime;
+        expired.clear();
         {
             Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
-            if (!m_destroyed)
-            {
-                if (Time() != scheduleTask.m_delay)
-                {
-                    std::map<TimerTaskPtr, Time, TimerTaskCompare>::iterator iter =
-                        m_alltasks.find(scheduleTask.m_task);
-                    if (iter != m_alltasks.end())
-                    {
-                        scheduleTask.m_scheduledtime = Time::Now(Time::Monotonic) + scheduleTask.m_delay;
-                        iter->second = scheduleTask.m_scheduledtime;
-                        m_scheduleTasks.insert(scheduleTask);
-                    }
-                }
-        
-                scheduleTask = ScheduleTask();
-
-                if (m_scheduleTasks.empty())
-                {
-                    m_taskWakeUpTime = Time();
-                    m_monitor.Wait();
-                }
-            }
-
-            if (m_destroyed)
+            if (!doSchedule(expired))
             {
                 break;
             }
-
-            if (!doSchedule(scheduleTask))
-            {
-                continue;
-            }
         }
 
-        if (m_destroyed)
+        if (m_pool)
         {
-            break;
+            dispatch(expired);
+            continue;
         }
 
-        if (0 != scheduleTask.m_task)
+        for (std::vector<ScheduleTask>::const_iterator iter = expired.begin(); iter != expired.end() && !m_destroyed; ++iter)
         {
-            try
-            {
-                scheduleTask.m_task->RunTimerTask();
-            }
-            catch(const Exception& e)
-            {
-                cerr << "Threading::Timer::Run(): uncaught exception:\n" << e.what();
-                cerr << endl;
-            } 
-            catch(const std::exception& e)
-            {
-                cerr << "Threading::Timer::Run(): uncaught exception:\n" << e.what() << endl;
-            } 
-            catch(...)
-            {
-                cerr << "Threading::Timer::Run(): uncaught exception" << endl;
-            }
+            runTask(*iter);
         }
-    }    
+    }
 }
 
-bool Timer::doSchedule(ScheduleTask& scheduleTask)
+//
+// Waits for expired tasks and takes them all out of the schedule, returns
+// false once the timer is destroyed.
+//
+bool Timer::doSchedule(std::vector<ScheduleTask>& expired)
 {
-    scheduleTask = ScheduleTask();
-
-    while (!m_scheduleTasks.empty() && !m_destroyed)
+    while (!m_destroyed)
     {
-        const ScheduleTask& firstTask = *m_scheduleTasks.begin();
+        if (m_queue->Empty())
+        {
+            m_taskWakeUpTime = Time();
+            m_monitor.Wait();
+            continue;
+        }
+
         Time now = Time::Now(Time::Monotonic);
 
-        if (firstTask.m_scheduledtime <= now)
+        ScheduleTask scheduleTask;
+        while (m_queue->PopExpired(now, scheduleTask))
         {
-            scheduleTask = firstTask;
-            m_scheduleTasks.erase(m_scheduleTasks.begin());  
-            if (firstTask.m_delay == Time()) 
+            if (Time() != scheduleTask.m_delay)
             {
-                m_alltasks.erase(scheduleTask.m_task);
+                m_running.insert(std::make_pair(scheduleTask.m_task, Time()));
             }
-            
-            return true; 
+            expired.push_back(scheduleTask);
+        }
+
+        if (!expired.empty())
+        {
+            return true;
         }
 
-        m_taskWakeUpTime = firstTask.m_scheduledtime;        
+        Time wakeUpTime = coalesce(m_queue->NextExpiry());
+        m_taskWakeUpTime = wakeUpTime;
 
         try
         {
-            m_monitor.TimedWait(firstTask.m_scheduledtime - now);    
+            m_monitor.TimedWait(wakeUpTime - now);
         }
         catch (const InvalidTimeoutException&)
         {
-            Time timeout = (firstTask.m_scheduledtime - now) / 2;
+            Time timeout = (wakeUpTime - now) / 2;
             while (timeout > Time())
             {
                 try
                 {
                     m_monitor.TimedWait(timeout);
-                    break;    
+                    break;
                 }
                 catch (const InvalidTimeoutException&)
                 {
@@ -252,4 +698,136 @@ bool Timer::doSchedule(ScheduleTask& scheduleTask)
     return false;
 }
 
-THREADING_END
\ No newline at end of file
+void Timer::dispatch(const std::vector<ScheduleTask>& expired)
+{
+    std::vector<TaskPtr> tasks;
+    tasks.reserve(expired.size());
+    for (std::vector<ScheduleTask>::const_iterator iter = expired.begin(); iter != expired.end(); ++iter)
+    {
+        tasks.push_back(new TimerDispatchTask(*this, *iter));
+    }
+
+    try
+    {
+        m_pool->SubmitTasks(tasks);
+    }
+    catch (const ThreadPoolDestroyedException&)
+    {
+        // The pool is gone, run the tasks here.
+        for (std::vector<ScheduleTask>::const_iterator iter = expired.begin(); iter != expired.end() && !m_destroyed; ++iter)
+        {
+            runTask(*iter);
+        }
+    }
+}
+
+//
+// Runs a task, then puts it back into the schedule if it is repeated and
+// was not cancelled meanwhile: when rescheduled meanwhile, at the time
+// asked for, at fixed rate, at the first period boundary still ahead,
+// else delay after now.
+//
+// A repeated task failing at every run would flood the log: the errors of
+// all the timers are limited to 10 at once, then 1 per second.
+//
+// A task still waiting in the ThreadPool when the timer is destroyed does
+// not run, as the expired tasks the timer thread has not run yet.
+//
+void Timer::runTask(const ScheduleTask& scheduleTask)
+{
+    {
+        Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+        if (m_destroyed)
+        {
+            return;
+        }
+    }
+
+    bool failed = true;
+    string error;
+    try
+    {
+        scheduleTask.m_task->RunTimerTask();
+        failed = false;
+    }
+    catch(const std::exception& e)
+    {
+        error = e.what();
+    }
+    catch(...)
+    {
+    }
+
+    if (failed)
+    {
+        UTIL_LOG_RATE_LIMITED(ERROR, 1, 10) << "Threading::Timer::Run(): uncaught exception"
+                                            << (error.empty() ? string() : ":\n" + error);
+    }
+
+    if (Time() == scheduleTask.m_delay)
+    {
+        return;
+    }
+
+    Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+    std::map<TimerTaskPtr, Time, TimerTaskCompare>::iterator running = m_running.find(scheduleTask.m_task);
+    if (m_destroyed || running == m_running.end())
+    {
+        return;
+    }
+
+    ScheduleTask next(scheduleTask);
+    Time now = Time::Now(Time::Monotonic);
+    if (Time() != running->second)
+    {
+        next.m_scheduledtime = running->second;
+    }
+    else if (next.m_fixedrate)
+    {
+        Int64 period = next.m_delay.ToMicroSeconds();
+        Int64 elapsed = (now - next.m_scheduledtime).ToMicroSeconds();
+        Int64 periods = elapsed > 0 ? elapsed / period + 1 : 1;
+        next.m_scheduledtime += Time::MicroSeconds(periods * period);
+    }
+    else
+    {
+        next.m_scheduledtime = now + next.m_delay;
+    }
+
+    m_running.erase(running);
+    insert(next);
+}
+
+void Timer::insert(const ScheduleTask& scheduleTask)
+{
+    if (m_running.find(scheduleTask.m_task) != m_running.end() || !m_queue->Insert(scheduleTask))
+    {
+        throw IllegalArgumentException(__FILE__, __LINE__, "task is already schedulded");
+    }
+
+    wakeUp(scheduleTask.m_scheduledtime);
+}
+
+// Wakes the timer thread up if it sleeps past scheduledtime.
+void Timer::wakeUp(const Time& scheduledtime)
+{
+    if (m_taskWakeUpTime == Time() || coalesce(scheduledtime) < m_taskWakeUpTime)
+    {
+        m_monitor.Notify();
+    }
+}
+
+// Rounds time up to a multiple of the slack.
+Time Timer::coalesce(const Time& time) const
+{
+    Int64 slack = m_slack.ToMicroSeconds();
+    if (slack <= 0)
+    {
+        return time;
+    }
+
+    Int64 microseconds = time.ToMicroSeconds();
+    return Time::MicroSeconds((microseconds + slack - 1) / slack * slack);
+}
+
+THREADING_END
@@ -1,2 +1,7 @@
-Logger$(OBJEXT): Logger.cpp "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/MutexPtrLock.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/FileUtil.h"
-LoggerUtil$(OBJEXT): LoggerUtil.cpp "$(includedir)/Logging/LoggerUtil.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/Shared.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h"
+Logger$(OBJEXT): Logger.cpp "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/AtomicSharedPtr.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Shared.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Logging/TimestampCache.h" "$(includedir)/Logging/BinaryLog.h"
+LoggerUtil$(OBJEXT): LoggerUtil.cpp "$(includedir)/Logging/LoggerUtil.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h"
+AsyncLogWriter$(OBJEXT): AsyncLogWriter.cpp "$(includedir)/Util/FileUtil.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Logging/AsyncLogWriter.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/Monitor.h" "$(includedir)/Concurrency/Cond.h" "$(includedir)/Concurrency/Semaphore.h" "$(includedir)/Concurrency/RingQueue.h" "$(includedir)/Concurrency/EventCount.h" "$(includedir)/Logging/LogSink.h"
+LogSink$(OBJEXT): LogSink.cpp "$(includedir)/Util/StringUtil.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/Properties.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Concurrency/MutexPtrLock.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Util/FileUtil.h"
+TimestampCache$(OBJEXT): TimestampCache.cpp "$(includedir)/Concurrency/ThreadLocal.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/TypeTraits.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Logging/TimestampCache.h"
+BinaryLog$(OBJEXT): BinaryLog.cpp "$(includedir)/Util/AtomicSharedPtr.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/MutexPtrLock.h" "$(includedir)/Logging/BinaryLog.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Logging/LogSink.h"
+LogRateLimit$(OBJEXT): LogRateLimit.cpp "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Concurrency/SpinMutex.h" "$(includedir)/Logging/LogRateLimit.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h"
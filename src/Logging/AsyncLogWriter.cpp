@@ -0,0 +1,346 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <errno.h>
+#include <fcntl.h>
+#ifdef _WIN32
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+#include <Util/FileUtil.h>
+#include <Util/StringUtil.h>
+#include <Logging/AsyncLogWriter.h>
+
+using namespace std;
+
+namespace
+{
+
+// Buffers grown larger than this by a long message are not recycled.
+const size_t MaxRecycledBuffer = 4 * 1024;
+
+}
+
+Threading::AsyncLogWriter::AsyncLogWriter(const string& file, const Time& flushinterval, size_t capacity,
+                                           OverflowPolicy policy, const LogRotation& rotation) :
+    Thread("Util async log writer"),
+    m_file(file),
+    m_flushinterval(flushinterval),
+    m_policy(policy),
+    m_rotation(rotation),
+    m_fd(-1),
+    m_size(0),
+    m_queue(capacity),
+    m_freebuffers(capacity),
+    m_dropped(0),
+    m_totaldropped(0),
+    m_closing(false),
+    m_producers(0),
+    m_destroyed(false),
+    m_stopped(false)
+{
+    if (!open())
+    {
+        throw InitializationException(__FILE__, __LINE__, "AsyncLogWriter: cannot open " + m_file);
+    }
+
+    SetNoDelete(true);
+    Start();
+    SetNoDelete(false);
+}
+
+Threading::AsyncLogWriter::~AsyncLogWriter()
+{
+    Destroy();
+
+    if (m_fd >= 0)
+    {
+#ifdef _WIN32
+        ::_close(m_fd);
+#else
+        ::close(m_fd);
+#endif
+    }
+}
+
+void
+Threading::AsyncLogWriter::Destroy()
+{
+    {
+        Monitor<Mutex>::LockGuard sync(m_monitor);
+        if (m_destroyed)
+        {
+            return;
+        }
+        m_destroyed = true;
+        m_closing = true;
+    }
+
+    if (GetThreadControl() == ThreadControl())
+    {
+        GetThreadControl().Detach();
+    }
+    else
+    {
+        GetThreadControl().Join();
+    }
+}
+
+void
+Threading::AsyncLogWriter::Write(const string& line, Color)
+{
+    LogBufferPtr buffer = allocBuffer();
+    buffer->m_data.reserve(line.size() + 1);
+    buffer->m_data.append(line);
+    buffer->m_data.push_back('\n');
+
+    //
+    // Either the writer thread sees us in m_producers and waits for our
+    // line, or we see m_closing and leave the queue alone.
+    //
+    ++m_producers;
+    if (m_closing)
+    {
+        --m_producers;
+        writeDirect(buffer->m_data);
+        recycleBuffer(buffer);
+        return;
+    }
+
+    if (OverflowBlock == m_policy)
+    {
+        m_queue.Push(buffer);
+    }
+    else if (!m_queue.TryPush(buffer))
+    {
+        --m_producers;
+        ++m_totaldropped;
+        if (OverflowCount == m_policy)
+        {
+            ++m_dropped;
+        }
+        recycleBuffer(buffer);
+        return;
+    }
+
+    --m_producers;
+}
+
+void
+Threading::AsyncLogWriter::Flush()
+{
+    //
+    // The lines queued so far are ahead of the marker: once the writer
+    // thread reaches it, they are written. After Destroy(), the writer
+    // thread writes everything queued anyway.
+    //
+    LogBufferPtr marker = new LogBuffer();
+    marker->m_marker = true;
+
+    ++m_producers;
+    if (m_closing)
+    {
+        --m_producers;
+        return;
+    }
+    m_queue.Push(marker);
+    --m_producers;
+
+    Monitor<Mutex>::LockGuard sync(m_monitor);
+    while (!marker->m_passed)
+    {
+        m_monitor.Wait();
+    }
+}
+
+size_t
+Threading::AsyncLogWriter::Dropped() const
+{
+    return static_cast<size_t>(static_cast<int>(m_totaldropped));
+}
+
+void
+Threading::AsyncLogWriter::Run()
+{
+    std::vector<LogBufferPtr> buffers;
+    std::vector<LogBufferPtr> markers;
+    string staging;
+    staging.reserve(BatchSize);
+    Time deadline;          // When staging must be written at the latest.
+
+    while (true)
+    {
+        bool destroyed = false;
+        {
+            Monitor<Mutex>::LockGuard sync(m_monitor);
+            destroyed = m_destroyed;
+        }
+
+        Time timeout = m_flushinterval;
+        if (destroyed)
+        {
+            timeout = Time();
+        }
+        else if (!staging.empty())
+        {
+            timeout = deadline - Time::Now(Time::Monotonic);
+        }
+
+        buffers.clear();
+        m_queue.PopBatch(buffers, m_queue.Capacity(), timeout);
+        if (staging.empty() && !buffers.empty())
+        {
+            deadline = Time::Now(Time::Monotonic) + m_flushinterval;
+        }
+
+        markers.clear();
+        for (std::vector<LogBufferPtr>::const_iterator iter = buffers.begin(); iter != buffers.end(); ++iter)
+        {
+            if ((*iter)->m_marker)
+            {
+                markers.push_back(*iter);
+                continue;
+            }
+            staging += (*iter)->m_data;
+            recycleBuffer(*iter);
+        }
+
+        int dropped = m_dropped;
+        if (dropped > 0)
+        {
+            m_dropped -= dropped;
+            staging += Format("%d log lines dropped, log queue full\n", dropped);
+        }
+
+        if (!staging.empty() &&
+            (destroyed || !markers.empty() || staging.size() >= BatchSize || Time::Now(Time::Monotonic) >= deadline))
+        {
+            rotate(staging.size());
+            writeAll(staging);
+            staging.clear();
+        }
+
+        if (!markers.empty())
+        {
+            Monitor<Mutex>::LockGuard sync(m_monitor);
+            for (std::vector<LogBufferPtr>::const_iterator iter = markers.begin(); iter != markers.end(); ++iter)
+            {
+                (*iter)->m_passed = true;
+            }
+            m_monitor.NotifyAll();
+        }
+
+        if (staging.empty() && destroyed && 0 == m_producers && m_queue.Empty())
+        {
+            break;
+        }
+    }
+
+    Monitor<Mutex>::LockGuard sync(m_monitor);
+    m_stopped = true;
+    m_monitor.NotifyAll();
+}
+
+bool
+Threading::AsyncLogWriter::open()
+{
+#ifdef _WIN32
+    m_fd = Threading::open(m_file, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY);
+#else
+    m_fd = Threading::open(m_file, O_WRONLY | O_CREAT | O_APPEND);
+#endif
+
+    structstat buf;
+    m_size = 0 == Threading::stat(m_file, &buf) ? static_cast<Int64>(buf.st_size) : 0;
+    m_opened = Time::Now(Time::Monotonic);
+    return m_fd >= 0;
+}
+
+void
+Threading::AsyncLogWriter::rotate(size_t bytes)
+{
+    if (!m_rotation.Enabled() || !m_rotation.Due(m_size, m_opened, bytes))
+    {
+        return;
+    }
+
+    if (m_fd >= 0)
+    {
+#ifdef _WIN32
+        ::_close(m_fd);
+#else
+        ::close(m_fd);
+#endif
+    }
+    m_rotation.Rotate(m_file);
+    if (!open())
+    {
+        cerr << "Threading::AsyncLogWriter: cannot reopen " << m_file << endl;
+    }
+}
+
+void
+Threading::AsyncLogWriter::writeAll(const string& data)
+{
+    const char* p = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0)
+    {
+#ifdef _WIN32
+        int written = ::_write(m_fd, p, static_cast<unsigned int>(remaining));
+#else
+        ssize_t written = ::write(m_fd, p, remaining);
+#endif
+        if (written < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            cerr << "Threading::AsyncLogWriter: cannot write " << m_file << endl;
+            return;
+        }
+        p += written;
+        remaining -= static_cast<size_t>(written);
+        m_size += static_cast<Int64>(written);
+    }
+}
+
+void
+Threading::AsyncLogWriter::writeDirect(const string& data)
+{
+    Monitor<Mutex>::LockGuard sync(m_monitor);
+    while (!m_stopped)
+    {
+        m_monitor.Wait();
+    }
+    rotate(data.size());
+    writeAll(data);
+}
+
+Threading::AsyncLogWriter::LogBufferPtr
+Threading::AsyncLogWriter::allocBuffer()
+{
+    LogBufferPtr buffer = m_freebuffers.TryPop();
+    if (!buffer)
+    {
+        buffer = new LogBuffer();
+    }
+    return buffer;
+}
+
+void
+Threading::AsyncLogWriter::recycleBuffer(const LogBufferPtr& buffer)
+{
+    if (buffer->m_data.capacity() <= MaxRecycledBuffer)
+    {
+        buffer->m_data.clear();
+        m_freebuffers.TryPush(buffer);
+    }
+}
@@ -0,0 +1,541 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+#include <Util/Atomic.h>
+#include <Util/AtomicSharedPtr.h>
+#include <Concurrency/MutexPtrLock.h>
+#include <Logging/BinaryLog.h>
+
+using namespace std;
+
+//
+// File layout, integers in the byte order of the writer:
+//
+//   header:  "UTILBLOG", unsigned int 0x01020304, unsigned int version
+//   site:    'S', unsigned int id, Byte level, int line, file, format
+//   message: 'M', unsigned int id, Int64 microseconds, arguments
+//
+// where strings and the arguments are an unsigned int size followed by the
+// bytes. Each argument is a type tag followed by the raw value.
+//
+// Every batch a writer flushes starts with a header and describes the sites
+// its messages refer to: site ids are only valid up to the next header, so
+// that the batches of processes appending to a file at once may interleave.
+//
+
+namespace
+{
+
+const char Magic[] = { 'U', 'T', 'I', 'L', 'B', 'L', 'O', 'G' };
+const unsigned int ByteOrder = 0x01020304;
+const unsigned int Version = 1;
+
+const char SiteRecord = 'S';
+const char MessageRecord = 'M';
+
+const char CharArg = 'c';
+const char IntArg = 'i';
+const char UIntArg = 'u';
+const char LongArg = 'l';
+const char ULongArg = 'L';
+const char DoubleArg = 'd';
+const char StringArg = 's';
+
+Threading::Mutex* sBinaryLogMutex = 0;
+Threading::AtomicSharedPtr<Threading::BinaryLogWriter>* sBinaryLog = 0;
+int sBinaryLogSites = 0;
+
+class Init
+{
+public:
+
+    Init()
+    {
+        sBinaryLogMutex = new Threading::Mutex;
+        sBinaryLog = new Threading::AtomicSharedPtr<Threading::BinaryLogWriter>;
+    }
+
+    ~Init()
+    {
+        delete sBinaryLog;
+        sBinaryLog = 0;
+        delete sBinaryLogMutex;
+        sBinaryLogMutex = 0;
+    }
+};
+
+Init init;
+
+template<typename T>
+inline void
+append(string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void
+appendString(string& out, const char* data, size_t size)
+{
+    append(out, static_cast<unsigned int>(size));
+    out.append(data, size);
+}
+
+// Reads a T at pos of data, throws if data is too short.
+template<typename T>
+T
+extract(const string& data, size_t& pos)
+{
+    if (data.size() - pos < sizeof(T))
+    {
+        throw Threading::IllegalArgumentException(__FILE__, __LINE__, "binary log: truncated arguments");
+    }
+
+    T value;
+    memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+template<typename T>
+string
+print(const char* format, T value)
+{
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), format, value);
+    buffer[sizeof(buffer) - 1] = '\0';
+    return buffer;
+}
+
+int
+siteId(Threading::BinaryLogSite& site)
+{
+    int id = Threading::AtomicLoad(&site.m_id, Threading::MemoryOrderAcquire);
+    if (0 == id)
+    {
+        Threading::MutexPtrLock<Threading::Mutex> lock(sBinaryLogMutex);
+        id = Threading::AtomicLoad(&site.m_id, Threading::MemoryOrderRelaxed);
+        if (0 == id)
+        {
+            id = ++sBinaryLogSites;
+            Threading::AtomicStore(&site.m_id, id, Threading::MemoryOrderRelease);
+        }
+    }
+    return id;
+}
+
+}
+
+Threading::BinaryLogWriter::BinaryLogWriter(const string& file) :
+    m_file(file)
+{
+#ifdef _WIN32
+    m_fd = Threading::open(file, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY);
+#else
+    m_fd = Threading::open(file, O_WRONLY | O_CREAT | O_APPEND);
+#endif
+    if (m_fd < 0)
+    {
+        throw InitializationException(__FILE__, __LINE__, "BinaryLogWriter: cannot open " + m_file);
+    }
+
+    m_buffer.reserve(BufferSize);
+}
+
+Threading::BinaryLogWriter::~BinaryLogWriter()
+{
+    Flush();
+
+#ifdef _WIN32
+    ::_close(m_fd);
+#else
+    ::close(m_fd);
+#endif
+}
+
+void
+Threading::BinaryLogWriter::Write(BinaryLogSite& site, const Time& time, const string& args)
+{
+    unsigned int id = static_cast<unsigned int>(siteId(site));
+
+    Threading::Mutex::LockGuard sync(m_mutex);
+    if (m_buffer.empty())
+    {
+        m_buffer.append(Magic, sizeof(Magic));
+        append(m_buffer, ByteOrder);
+        append(m_buffer, Version);
+    }
+
+    if (id >= m_sites.size())
+    {
+        m_sites.resize(id + 1, false);
+    }
+
+    if (!m_sites[id])
+    {
+        m_buffer += SiteRecord;
+        append(m_buffer, id);
+        append(m_buffer, static_cast<Byte>(site.m_level));
+        append(m_buffer, site.m_line);
+        appendString(m_buffer, site.m_file, strlen(site.m_file));
+        appendString(m_buffer, site.m_format, strlen(site.m_format));
+        m_sites[id] = true;
+    }
+
+    m_buffer += MessageRecord;
+    append(m_buffer, id);
+    append(m_buffer, time.ToMicroSeconds());
+    appendString(m_buffer, args.data(), args.size());
+
+    if (m_buffer.size() >= BufferSize || site.m_level >= LOGLEVEL_ERROR)
+    {
+        flush();
+    }
+}
+
+void
+Threading::BinaryLogWriter::Flush()
+{
+    Threading::Mutex::LockGuard sync(m_mutex);
+    flush();
+}
+
+void
+Threading::BinaryLogWriter::flush()
+{
+    if (m_buffer.empty())
+    {
+        return;
+    }
+
+    //
+    // One write() on an O_APPEND descriptor, not a stream that may split
+    // the batch; the loop only resumes a write cut short by a signal or a
+    // full disk.
+    //
+    const char* p = m_buffer.data();
+    size_t remaining = m_buffer.size();
+    while (remaining > 0)
+    {
+#ifdef _WIN32
+        int written = ::_write(m_fd, p, static_cast<unsigned int>(remaining));
+#else
+        ssize_t written = ::write(m_fd, p, remaining);
+#endif
+        if (written < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            cerr << "Threading::BinaryLogWriter: cannot write " << m_file << endl;
+            break;
+        }
+        p += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    m_buffer.clear();
+    m_sites.assign(m_sites.size(), false);
+}
+
+void
+Threading::SetBinaryLog(const BinaryLogWriterPtr& writer)
+{
+    if (0 != sBinaryLog)
+    {
+        sBinaryLog->Store(writer);
+    }
+}
+
+Threading::BinaryLogWriterPtr
+Threading::GetBinaryLog()
+{
+    return 0 != sBinaryLog ? sBinaryLog->Load() : BinaryLogWriterPtr();
+}
+
+string
+Threading::FormatBinaryLog(const string& format, const string& args)
+{
+    vector<string> values;
+    size_t pos = 0;
+    while (pos < args.size())
+    {
+        char tag = args[pos++];
+        switch (tag)
+        {
+        case CharArg:
+            values.push_back(string(1, extract<char>(args, pos)));
+            break;
+        case IntArg:
+            values.push_back(print("%d", extract<int>(args, pos)));
+            break;
+        case UIntArg:
+            values.push_back(print("%u", extract<uint>(args, pos)));
+            break;
+        case LongArg:
+            values.push_back(print("%lld", static_cast<long long>(extract<Int64>(args, pos))));
+            break;
+        case ULongArg:
+            values.push_back(print("%llu", static_cast<unsigned long long>(extract<UInt64>(args, pos))));
+            break;
+        case DoubleArg:
+            values.push_back(print("%g", extract<double>(args, pos)));
+            break;
+        case StringArg:
+        {
+            size_t size = extract<unsigned int>(args, pos);
+            if (args.size() - pos < size)
+            {
+                throw IllegalArgumentException(__FILE__, __LINE__, "binary log: truncated arguments");
+            }
+            values.push_back(args.substr(pos, size));
+            pos += size;
+            break;
+        }
+        default:
+            throw IllegalArgumentException(__FILE__, __LINE__, "binary log: unknown argument type");
+        }
+    }
+
+    string text;
+    text.reserve(format.size() + args.size());
+    vector<string>::const_iterator value = values.begin();
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        if ('{' == format[i] && i + 1 < format.size() && '}' == format[i + 1] && value != values.end())
+        {
+            text += *value++;
+            ++i;
+        }
+        else
+        {
+            text += format[i];
+        }
+    }
+    for (; value != values.end(); ++value)
+    {
+        text += ' ';
+        text += *value;
+    }
+    return text;
+}
+
+Threading::BinaryLogRecord::BinaryLogRecord(BinaryLogSite& site, const LoggerPtr& logger) :
+    m_site(site),
+    m_logger(logger)
+{
+}
+
+Threading::BinaryLogRecord&
+Threading::BinaryLogRecord::operator<<(const string& value)
+{
+    m_args += StringArg;
+    appendString(m_args, value.data(), value.size());
+    return *this;
+}
+
+Threading::BinaryLogRecord&
+Threading::BinaryLogRecord::operator<<(const char* value)
+{
+    if (0 == value)
+    {
+        value = "(null)";
+    }
+    m_args += StringArg;
+    appendString(m_args, value, strlen(value));
+    return *this;
+}
+
+#undef DECLARE_STREAM_OPERATOR
+#define DECLARE_STREAM_OPERATOR(TYPE, TAG, STORED)                      \
+    Threading::BinaryLogRecord&                                         \
+    Threading::BinaryLogRecord::operator<<(TYPE value)                  \
+    {                                                                   \
+        m_args += TAG;                                                  \
+        append(m_args, static_cast<STORED>(value));                     \
+        return *this;                                                   \
+    }
+
+DECLARE_STREAM_OPERATOR(char         , CharArg  , char  )
+DECLARE_STREAM_OPERATOR(int          , IntArg   , int   )
+DECLARE_STREAM_OPERATOR(uint         , UIntArg  , uint  )
+DECLARE_STREAM_OPERATOR(long         , LongArg  , Int64 )
+DECLARE_STREAM_OPERATOR(unsigned long, ULongArg , UInt64)
+DECLARE_STREAM_OPERATOR(double       , DoubleArg, double)
+#undef DECLARE_STREAM_OPERATOR
+
+void
+Threading::BinaryLogRecord::Finish() const
+{
+    BinaryLogWriterPtr writer = m_logger ? m_logger->BinaryLog() : GetBinaryLog();
+    if (writer)
+    {
+        writer->Write(m_site, Time::Now(), m_args);
+        if (LOGLEVEL_FATAL != m_site.m_level)
+        {
+            return;
+        }
+    }
+
+    string text = FormatBinaryLog(m_site.m_format, m_args);
+    if (m_logger && LOGLEVEL_FATAL != m_site.m_level)
+    {
+        switch (m_site.m_level)
+        {
+        case LOGLEVEL_INFO:
+            m_logger->Trace("", text);
+            break;
+        case LOGLEVEL_WARNING:
+            m_logger->Warning(text);
+            break;
+        default:
+            m_logger->Error(text);
+            break;
+        }
+        return;
+    }
+
+    // Through the log handler, which also aborts on fatal messages.
+    internal::LogMessage message(m_site.m_level, m_site.m_file, m_site.m_line);
+    message << text;
+    internal::LogFinisher() = message;
+}
+
+void
+Threading::internal::BinaryLogFinisher::operator=(const BinaryLogRecord& record)
+{
+    record.Finish();
+}
+
+Threading::BinaryLogReader::BinaryLogReader(istream& in) :
+    m_in(in),
+    m_header(false)
+{
+}
+
+bool
+Threading::BinaryLogReader::Next(BinaryLogEntry& entry)
+{
+    while (true)
+    {
+        int type = m_in.get();
+        if (char_traits<char>::eof() == type)
+        {
+            return false;
+        }
+
+        if (Magic[0] == type)
+        {
+            m_in.unget();
+            readHeader();
+            continue;
+        }
+
+        if (!m_header)
+        {
+            throw IllegalArgumentException(__FILE__, __LINE__, "binary log: missing header");
+        }
+
+        if (SiteRecord == type)
+        {
+            unsigned int id = read<unsigned int>();
+            unsigned int level = read<Byte>();
+            if (level > LOGLEVEL_FATAL)
+            {
+                throw IllegalArgumentException(__FILE__, __LINE__, "binary log: invalid level");
+            }
+            if (id >= m_sites.size())
+            {
+                Site undefined;
+                undefined.m_defined = false;
+                m_sites.resize(id + 1, undefined);
+            }
+
+            Site& site = m_sites[id];
+            site.m_defined = true;
+            site.m_level = static_cast<LogSeverity>(level);
+            site.m_line = read<int>();
+            site.m_file = readString();
+            site.m_format = readString();
+        }
+        else if (MessageRecord == type)
+        {
+            unsigned int id = read<unsigned int>();
+            Int64 usecs = read<Int64>();
+            string args = readString();
+            if (id >= m_sites.size() || !m_sites[id].m_defined)
+            {
+                throw IllegalArgumentException(__FILE__, __LINE__, "binary log: message of an unknown site");
+            }
+
+            const Site& site = m_sites[id];
+            entry.m_level = site.m_level;
+            entry.m_file = site.m_file;
+            entry.m_line = site.m_line;
+            entry.m_time = Time::MicroSeconds(usecs);
+            entry.m_text = FormatBinaryLog(site.m_format, args);
+            return true;
+        }
+        else
+        {
+            throw IllegalArgumentException(__FILE__, __LINE__, "binary log: unknown record type");
+        }
+    }
+}
+
+void
+Threading::BinaryLogReader::readHeader()
+{
+    char magic[sizeof(Magic)];
+    read(magic, sizeof(magic));
+    if (0 != memcmp(magic, Magic, sizeof(Magic)))
+    {
+        throw IllegalArgumentException(__FILE__, __LINE__, "binary log: bad magic");
+    }
+    if (read<unsigned int>() != ByteOrder)
+    {
+        throw IllegalArgumentException(__FILE__, __LINE__, "binary log: written with another byte order");
+    }
+    if (read<unsigned int>() != Version)
+    {
+        throw IllegalArgumentException(__FILE__, __LINE__, "binary log: unsupported version");
+    }
+
+    m_header = true;
+    m_sites.clear();
+}
+
+void
+Threading::BinaryLogReader::read(void* data, size_t size)
+{
+    m_in.read(static_cast<char*>(data), static_cast<streamsize>(size));
+    if (static_cast<size_t>(m_in.gcount()) != size)
+    {
+        throw IllegalArgumentException(__FILE__, __LINE__, "binary log: truncated record");
+    }
+}
+
+string
+Threading::BinaryLogReader::readString()
+{
+    unsigned int size = read<unsigned int>();
+    string s(size, '\0');
+    if (size > 0)
+    {
+        read(&s[0], size);
+    }
+    return s;
+}
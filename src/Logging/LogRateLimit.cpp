@@ -0,0 +1,142 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <Util/Time.h>
+#include <Util/StringUtil.h>
+#include <Concurrency/SpinMutex.h>
+#include <Logging/LogRateLimit.h>
+
+using namespace std;
+
+namespace
+{
+
+//
+// Locks the site through the spin mutex pool, the sites being PODs
+// without a mutex of their own.
+//
+class SiteLock
+{
+public:
+
+    explicit SiteLock(const Threading::LogSite& site) :
+        m_mutex(Threading::GetSpinMutex(&site))
+    {
+        m_mutex.Lock();
+    }
+
+    ~SiteLock()
+    {
+        m_mutex.Unlock();
+    }
+
+private:
+
+    Threading::SpinMutex& m_mutex;
+};
+
+// Admits an occurrence of site, reporting the occurrences dropped before.
+inline bool
+admit(Threading::LogSite& site)
+{
+    site.m_report += site.m_suppressed;
+    site.m_suppressed = 0;
+    return true;
+}
+
+inline bool
+drop(Threading::LogSite& site)
+{
+    ++site.m_suppressed;
+    return false;
+}
+
+}
+
+bool
+Threading::LogEveryN(LogSite& site, int n)
+{
+    if (n <= 1)
+    {
+        return true;
+    }
+
+    // Wraps around at n, not at INT_MAX, so that sampling never skips.
+    SiteLock sync(site);
+    int count = site.m_count % n;
+    site.m_count = count + 1;
+    return 0 == count;
+}
+
+bool
+Threading::LogFirstN(LogSite& site, int n)
+{
+    SiteLock sync(site);
+    if (site.m_count >= n)
+    {
+        return false;
+    }
+    ++site.m_count;
+    return true;
+}
+
+bool
+Threading::LogEveryT(LogSite& site, double seconds)
+{
+    Int64 now = Time::Now(Time::Monotonic).ToMicroSeconds();
+
+    SiteLock sync(site);
+    if (site.m_seen && static_cast<double>(now - site.m_last) < seconds * 1000000)
+    {
+        return drop(site);
+    }
+    site.m_seen = true;
+    site.m_last = now;
+    return admit(site);
+}
+
+bool
+Threading::LogRateLimited(LogSite& site, double rate, double burst)
+{
+    Int64 now = Time::Now(Time::Monotonic).ToMicroSeconds();
+
+    SiteLock sync(site);
+    if (!site.m_seen)
+    {
+        site.m_seen = true;
+        site.m_tokens = burst;
+    }
+    else
+    {
+        site.m_tokens += static_cast<double>(now - site.m_last) / 1000000 * rate;
+        if (site.m_tokens > burst)
+        {
+            site.m_tokens = burst;
+        }
+    }
+    site.m_last = now;
+
+    if (site.m_tokens < 1)
+    {
+        return drop(site);
+    }
+    site.m_tokens -= 1;
+    return admit(site);
+}
+
+string
+Threading::TakeSuppressed(LogSite& site)
+{
+    int report = 0;
+    {
+        SiteLock sync(site);
+        report = site.m_report;
+        site.m_report = 0;
+    }
+    return 0 == report ? string() : Format("(%d messages suppressed) ", report);
+}
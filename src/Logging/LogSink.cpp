@@ -0,0 +1,400 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <map>
+#include <Util/StringUtil.h>
+#include <Util/Properties.h>
+#include <Concurrency/MutexPtrLock.h>
+#include <Concurrency/Monitor.h>
+#include <Concurrency/Thread.h>
+#include <Logging/ColorStream.h>
+#include <Logging/LogSink.h>
+
+using namespace std;
+
+namespace
+{
+
+typedef Threading::SharedPtr<Threading::FileLogSink> FileLogSinkPtr;
+
+//
+// Rotates the files of the FileLogSinks on its own thread, so that their
+// writers never wait for the files to be renamed and reopened.
+//
+class LogRotator : public Threading::Thread
+{
+public:
+
+    LogRotator() :
+        Thread("Util log rotator"),
+        m_destroyed(false)
+    {
+    }
+
+    void Add(const FileLogSinkPtr& sink)
+    {
+        Threading::Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+        m_sinks.push_back(sink);
+        m_monitor.Notify();
+    }
+
+    // Rotates the files still due and stops the thread.
+    void Destroy()
+    {
+        {
+            Threading::Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+            m_destroyed = true;
+            m_monitor.Notify();
+        }
+        GetThreadControl().Join();
+    }
+
+    virtual void Run()
+    {
+        while (true)
+        {
+            std::vector<FileLogSinkPtr> sinks;
+            {
+                Threading::Monitor<Threading::Mutex>::LockGuard sync(m_monitor);
+                while (!m_destroyed && m_sinks.empty())
+                {
+                    m_monitor.Wait();
+                }
+                if (m_sinks.empty())
+                {
+                    return;
+                }
+                sinks.swap(m_sinks);
+            }
+
+            for (std::vector<FileLogSinkPtr>::const_iterator iter = sinks.begin(); iter != sinks.end(); ++iter)
+            {
+                (*iter)->Rotate();
+            }
+        }
+    }
+
+private:
+
+    Threading::Monitor<Threading::Mutex> m_monitor;
+    bool m_destroyed;
+    std::vector<FileLogSinkPtr> m_sinks;
+};
+typedef Threading::SharedPtr<LogRotator> LogRotatorPtr;
+
+Threading::Mutex* sSinksMutex = 0;
+Threading::LogSinkPtr* sStderrSink = 0;
+std::map<std::string, Threading::LogSinkPtr>* sFileSinks = 0;
+Threading::Mutex* sRotatorMutex = 0;
+LogRotatorPtr* sRotator = 0;
+
+class Init
+{
+public:
+
+    Init()
+    {
+        sSinksMutex = new Threading::Mutex;
+        sStderrSink = new Threading::LogSinkPtr;
+        sFileSinks = new std::map<std::string, Threading::LogSinkPtr>;
+        sRotatorMutex = new Threading::Mutex;
+        sRotator = new LogRotatorPtr;
+    }
+
+    ~Init()
+    {
+        //
+        // The sinks rotate on their writers' threads from now on.
+        //
+        LogRotatorPtr rotator;
+        {
+            Threading::MutexPtrLock<Threading::Mutex> lock(sRotatorMutex);
+            rotator = *sRotator;
+            delete sRotator;
+            sRotator = 0;
+        }
+        if (rotator)
+        {
+            rotator->Destroy();
+        }
+        delete sRotatorMutex;
+        sRotatorMutex = 0;
+
+        delete sFileSinks;
+        sFileSinks = 0;
+        delete sStderrSink;
+        sStderrSink = 0;
+        delete sSinksMutex;
+        sSinksMutex = 0;
+    }
+};
+
+Init init;
+
+// Starts the rotator thread unless it runs already.
+void
+startRotator()
+{
+    Threading::MutexPtrLock<Threading::Mutex> lock(sRotatorMutex);
+    if (0 != sRotator && !*sRotator)
+    {
+        LogRotatorPtr rotator = new LogRotator();
+        rotator->Start();
+        *sRotator = rotator;
+    }
+}
+
+// Has sink rotated by the rotator thread, or by the caller without one.
+void
+rotate(const FileLogSinkPtr& sink)
+{
+    LogRotatorPtr rotator;
+    {
+        Threading::MutexPtrLock<Threading::Mutex> lock(sRotatorMutex);
+        if (0 != sRotator)
+        {
+            rotator = *sRotator;
+        }
+    }
+
+    if (rotator)
+    {
+        rotator->Add(sink);
+    }
+    else
+    {
+        sink->Rotate();
+    }
+}
+
+}
+
+Threading::LogRotation::LogRotation() :
+    m_maxsize(0),
+    m_keep(0)
+{
+}
+
+Threading::LogRotation::LogRotation(Int64 maxsize, const Time& maxage, int keep) :
+    m_maxsize(maxsize),
+    m_maxage(maxage),
+    m_keep(keep)
+{
+}
+
+Threading::LogRotation
+Threading::LogRotation::Load(const PropertiesPtr& properties, const string& prefix)
+{
+    Int64 maxsize = properties->GetPropertyAsIntWithDefault(prefix + ".MaxSize", 0);
+    Int64 maxage = properties->GetPropertyAsIntWithDefault(prefix + ".MaxAge", 0);
+    int keep = properties->GetPropertyAsIntWithDefault(prefix + ".Keep", 5);
+    return LogRotation(maxsize * 1024, Time::Seconds(maxage), keep);
+}
+
+bool
+Threading::LogRotation::Due(Int64 size, const Time& opened, size_t bytes) const
+{
+    if (0 == size)
+    {
+        return false;
+    }
+
+    if (m_maxsize > 0 && size + static_cast<Int64>(bytes) > m_maxsize)
+    {
+        return true;
+    }
+    return m_maxage > Time() && Time::Now(Time::Monotonic) - opened >= m_maxage;
+}
+
+void
+Threading::LogRotation::Rotate(const string& file) const
+{
+    if (m_keep <= 0)
+    {
+        Threading::remove(file);
+        return;
+    }
+
+    //
+    // Remove the targets first, rename() does not replace files on
+    // Windows.
+    //
+    Threading::remove(Format("%s.%d", file.c_str(), m_keep));
+    for (int i = m_keep - 1; i > 0; --i)
+    {
+        string from = Format("%s.%d", file.c_str(), i);
+        if (FileExists(from))
+        {
+            Threading::rename(from, Format("%s.%d", file.c_str(), i + 1));
+        }
+    }
+    if (0 != Threading::rename(file, file + ".1"))
+    {
+        cerr << "Threading::LogRotation: cannot rename " << file << endl;
+    }
+}
+
+Threading::FileLogSink::FileLogSink(const string& file, const LogRotation& rotation) :
+    m_file(file),
+    m_rotation(rotation),
+    m_out(new Threading::ofstream()),
+    m_size(0),
+    m_rotating(false)
+{
+    m_size = open(*m_out);
+    m_opened = Time::Now(Time::Monotonic);
+    if (!m_out->is_open())
+    {
+        throw InitializationException(__FILE__, __LINE__, "FileLogger: cannot open " + m_file);
+    }
+
+    if (m_rotation.Enabled())
+    {
+        startRotator();
+    }
+}
+
+Threading::LogSinkPtr
+Threading::FileLogSink::Open(const string& file, const LogRotation& rotation)
+{
+    Threading::MutexPtrLock<Threading::Mutex> lock(sSinksMutex);
+    if (0 == sFileSinks)
+    {
+        return new FileLogSink(file, rotation);
+    }
+
+    //
+    // Close the sinks nobody uses any more.
+    //
+    for (map<string, LogSinkPtr>::iterator iter = sFileSinks->begin(); iter != sFileSinks->end(); )
+    {
+        if (1 == iter->second->GetRef() && iter->first != file)
+        {
+            sFileSinks->erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    LogSinkPtr& sink = (*sFileSinks)[file];
+    if (!sink)
+    {
+        sink = new FileLogSink(file, rotation);
+    }
+    return sink;
+}
+
+void
+Threading::FileLogSink::Write(const string& line, Color)
+{
+    bool due = false;
+    {
+        Threading::Mutex::LockGuard sync(m_mutex);
+        if (!m_rotating && m_rotation.Enabled() && m_rotation.Due(m_size, m_opened, line.size() + 1))
+        {
+            m_rotating = true;
+            due = true;
+        }
+
+        *m_out << line << endl;
+        m_size += static_cast<Int64>(line.size() + 1);
+    }
+
+    if (due)
+    {
+        rotate(this);
+    }
+}
+
+void
+Threading::FileLogSink::Flush()
+{
+    Threading::Mutex::LockGuard sync(m_mutex);
+    m_out->flush();
+}
+
+void
+Threading::FileLogSink::Rotate()
+{
+    Threading::Mutex::LockGuard rotating(m_rotatemutex);
+    UniquePtr<Threading::ofstream> out(new Threading::ofstream());
+#ifdef _WIN32
+    //
+    // An open file cannot be renamed: the writers wait until the new file
+    // is open.
+    //
+    Threading::Mutex::LockGuard sync(m_mutex);
+    m_out->close();
+    m_rotation.Rotate(m_file);
+    Int64 size = open(*out);
+#else
+    //
+    // The writers keep appending to the open file, renamed, until the new
+    // one is swapped in.
+    //
+    m_rotation.Rotate(m_file);
+    Int64 size = open(*out);
+    Threading::Mutex::LockGuard sync(m_mutex);
+#endif
+    m_rotating = false;
+    if (!out->is_open())
+    {
+        cerr << "Threading::FileLogSink: cannot reopen " << m_file << endl;
+        return;
+    }
+
+    m_out.Swap(out);
+    m_size = size;
+    m_opened = Time::Now(Time::Monotonic);
+}
+
+Threading::Int64
+Threading::FileLogSink::open(Threading::ofstream& out) const
+{
+    out.open(m_file, fstream::out | fstream::app);
+
+    structstat buf;
+    return 0 == Threading::stat(m_file, &buf) ? static_cast<Int64>(buf.st_size) : 0;
+}
+
+Threading::LogSinkPtr
+Threading::StderrLogSink::Instance()
+{
+    Threading::MutexPtrLock<Threading::Mutex> lock(sSinksMutex);
+    if (0 == sStderrSink)
+    {
+        return new StderrLogSink();
+    }
+
+    if (!*sStderrSink)
+    {
+        *sStderrSink = new StderrLogSink();
+    }
+    return *sStderrSink;
+}
+
+void
+Threading::StderrLogSink::Write(const string& line, Color color)
+{
+    Threading::Mutex::LockGuard sync(m_mutex);
+    colorostream out(cerr);
+    if (0 != color)
+    {
+        out.tostd() << color;
+    }
+    out.tostd() << line << endl;
+}
+
+void
+Threading::StderrLogSink::Flush()
+{
+    Threading::Mutex::LockGuard sync(m_mutex);
+    cerr.flush();
+}
@@ -9,10 +9,11 @@
 #include <stdio.h>
 #include <Util/Time.h>
 #include <Util/StringUtil.h>
-#include <Concurrency/Mutex.h>
-#include <Concurrency/MutexPtrLock.h>
+#include <Util/AtomicSharedPtr.h>
 #include <Unicoder/StringConverter.h>
 #include <Logging/Logger.h>
+#include <Logging/TimestampCache.h>
+#include <Logging/BinaryLog.h>
 
 using namespace std;
 using namespace Threading;
@@ -21,9 +22,8 @@ using namespace Threading;
 namespace
 {
 
-Threading::Mutex* outputMutex = 0;
-static Threading::Mutex* sProcessLoggerMutex = 0;
-static Threading::LoggerPtr sProcessLogger;
+Threading::AtomicSharedPtr<Threading::Logger>* sProcessLogger = 0;
+volatile Threading::LogSeverity sLogLevel = Threading::LOGLEVEL_INFO;
 
 class Init
 {
@@ -31,16 +31,13 @@ public:
 
     Init()
     {
-        outputMutex = new Threading::Mutex;
-        sProcessLoggerMutex = new Threading::Mutex;
+        sProcessLogger = new Threading::AtomicSharedPtr<Threading::Logger>;
     }
 
     ~Init()
     {
-        delete outputMutex;
-        outputMutex = 0;
-        delete sProcessLoggerMutex;
-        sProcessLoggerMutex = 0;
+        delete sProcessLogger;
+        sProcessLogger = 0;
     }
 };
 
@@ -50,50 +47,91 @@ Init init;
 LoggerPtr
 Threading::GetProcessLogger()
 {
-    Threading::MutexPtrLock<Threading::Mutex> lock(sProcessLoggerMutex);
+    if (0 == sProcessLogger)
+    {
+        return new Threading::Logger("", "");
+    }
 
-    if (sProcessLogger == 0)
+    LoggerPtr logger = sProcessLogger->Load();
+    if (logger == 0)
     {
-        sProcessLogger = new Threading::Logger("", "");
+        //
+        // Only one default logger is installed, the loser of the race
+        // returns the winner's.
+        //
+        LoggerPtr created = new Threading::Logger("", "");
+        if (sProcessLogger->CompareExchange(logger, created))
+        {
+            logger = created;
+        }
     }
-    return sProcessLogger;
+    return logger;
 }
 
 void
 Threading::SetProcessLogger(const LoggerPtr& logger)
 {
-    Threading::MutexPtrLock<Threading::Mutex> lock(sProcessLoggerMutex);
-    sProcessLogger = logger;
+    if (0 != sProcessLogger)
+    {
+        sProcessLogger->Store(logger);
+    }
+}
+
+
+void
+Threading::SetLogLevel(LogSeverity level)
+{
+    sLogLevel = level;
+}
+
+Threading::LogSeverity
+Threading::GetLogLevel()
+{
+    return sLogLevel;
 }
 
+bool
+Threading::IsLogEnabled(LogSeverity level)
+{
+    return level >= sLogLevel || LOGLEVEL_FATAL == level;
+}
 
-Threading::Logger::Logger(const string& prefix, const string& file)
+Threading::Logger::Logger() :
+    m_level(LOGLEVEL_INFO)
+{
+}
+
+Threading::Logger::Logger(const string& prefix, const string& file, const LogRotation& rotation) :
+    m_level(LOGLEVEL_INFO)
 {
     if (!prefix.empty())
     {
         m_prefix = prefix + ": ";
     }
 
-    if (!file.empty())
-    {
-        m_file = file;
-        m_out.open(file, fstream::out | fstream::app);
-        if (!m_out.is_open())
-        {
-            throw InitializationException(__FILE__, __LINE__, "FileLogger: cannot open " + m_file);
-        }
-    }
+    m_sink = file.empty() ? StderrLogSink::Instance() : FileLogSink::Open(file, rotation);
 }
 
 
-Threading::Logger::~Logger()
+Threading::Logger::Logger(const string& prefix, const LogSinkPtr& sink) :
+    m_sink(sink),
+    m_level(LOGLEVEL_INFO)
 {
-    if (m_out.is_open())
+    if (!prefix.empty())
     {
-        m_out.close();
+        m_prefix = prefix + ": ";
+    }
+
+    if (!m_sink)
+    {
+        throw InitializationException(__FILE__, __LINE__, "Logger: null sink");
     }
 }
 
+Threading::Logger::~Logger()
+{
+}
+
 void
 Threading::Logger::Print(const string& message)
 {
@@ -103,7 +141,15 @@ Threading::Logger::Print(const string& message)
 void
 Threading::Logger::Trace(const string& category, const string& message)
 {
-    string s = "--[  INFO ] " + Threading::Time::Now().ToDateTime() + " " + m_prefix;
+    if (!IsEnabled(LOGLEVEL_INFO))
+    {
+        return;
+    }
+
+    string s = "--[  INFO ] ";
+    AppendLogTimestamp(s);
+    s += " ";
+    s += m_prefix;
     if (!category.empty())
     {
         s += category + ": ";
@@ -116,50 +162,82 @@ Threading::Logger::Trace(const string& category, const string& message)
 void
 Threading::Logger::Warning(const string& message)
 {
-    Write("-![WARNING] " + Threading::Time::Now().ToDateTime() + " " + m_prefix + "warning: " + message, true, fgyellow);
+    if (!IsEnabled(LOGLEVEL_WARNING))
+    {
+        return;
+    }
+
+    string s = "-![WARNING] ";
+    AppendLogTimestamp(s);
+    s += " ";
+    s += m_prefix;
+    s += "warning: ";
+    s += message;
+
+    Write(s, true, fgyellow);
 }
 
 void
 Threading::Logger::Error(const string& message)
 {
-    Write("!![ ERROR ] " + Threading::Time::Now().ToDateTime() + " " + m_prefix + "error: " + message, true, fgred);
+    if (!IsEnabled(LOGLEVEL_ERROR))
+    {
+        return;
+    }
+
+    string s = "!![ ERROR ] ";
+    AppendLogTimestamp(s);
+    s += " ";
+    s += m_prefix;
+    s += "error: ";
+    s += message;
+
+    Write(s, true, fgred);
 }
 
 LoggerPtr
 Threading::Logger::CloneWithPrefix(const std::string& prefix)
 {
-    return new Logger(prefix, m_file);
+    LoggerPtr logger = new Logger(prefix, m_sink ? m_sink : StderrLogSink::Instance());
+    logger->SetLevel(m_level);
+    logger->SetBinaryLog(m_binarylog);
+    return logger;
 }
 
 void
-Threading::Logger::Write(const string& message, bool indent, ostream& (*color)(ostream &out))
+Threading::Logger::SetBinaryLog(const BinaryLogWriterPtr& writer)
 {
-    Threading::MutexPtrLock<Threading::Mutex> sync(outputMutex);
-
-    string s = message;
+    m_binarylog = writer;
+}
 
-    if (indent)
+void
+Threading::Logger::Write(const string& message, bool indent, ostream& (*color)(ostream &out))
+{
+    //
+    // Indent continuation lines, building the result in one pass.
+    //
+    string indented;
+    if (indent && message.find('\n') != string::npos)
     {
-        string::size_type idx = 0;
-        while ((idx = s.find("\n", idx)) != string::npos)
+        indented.reserve(message.size() + 64);
+        for (string::const_iterator iter = message.begin(); iter != message.end(); ++iter)
         {
-            s.insert(idx + 1, "   ");
-            ++idx;
+            indented += *iter;
+            if ('\n' == *iter)
+            {
+                indented += "   ";
+            }
         }
     }
+    const string& s = indented.empty() ? message : indented;
 
-    if (m_out.is_open())
+    if (m_sink)
     {
-        m_out << s << endl;
+        m_sink->Write(s, color);
     }
     else
     {
-        colorostream out(cerr);
-        if (0 != color)
-        {
-            out.tostd() << color;
-        }
-        out.tostd() << s << endl;
+        StderrLogSink::Instance()->Write(s, color);
     }
 }
 
@@ -212,7 +290,10 @@ Threading::StderrLog::StderrLog(LogSeverity severity, const char* file, int line
         color = &fgred<char>;
     }
 
-    GetStream() << ::std::endl << color << marker << " "
+    string timestamp;
+    AppendLogTimestamp(timestamp);
+
+    GetStream() << ::std::endl << color << marker << " " << timestamp << " "
         << FormatFileLocation(file, line).c_str() << ": ";
 }
 
@@ -11,6 +11,11 @@
 
 using namespace std;
 
+Threading::LoggerOutputBase::LoggerOutputBase(bool enabled) :
+    m_enabled(enabled)
+{
+}
+
 string
 Threading::LoggerOutputBase::Str() const
 {
@@ -26,25 +31,35 @@ Threading::LoggerOutputBase::Strstream()
 Threading::LoggerOutputBase&
 Threading::operator <<(Threading::LoggerOutputBase& out, std::ios_base& (*val)(std::ios_base&))
 {
-    out.Strstream() << val;
+    if (out.Enabled())
+    {
+        out.Strstream() << val;
+    }
     return out;
 }
 
 Threading::LoggerOutputBase& 
 Threading::operator <<(Threading::LoggerOutputBase& out, std::ostream& (*val)(std::ostream&))
 {
-    out.Strstream() << val;
+    if (out.Enabled())
+    {
+        out.Strstream() << val;
+    }
     return out;
 }
 
 Threading::LoggerOutputBase&
 Threading::operator <<(Threading::LoggerOutputBase& out, const std::exception& ex)
 {
-    out.Strstream() << ex.what();
+    if (out.Enabled())
+    {
+        out.Strstream() << ex.what();
+    }
     return out;
 }
 
 Threading::Trace::Trace(const LoggerPtr& logger, const string& category) :
+    LoggerOutputBase(logger->IsEnabled(LOGLEVEL_INFO)),
     m_logger(logger),
     m_category(category)
 {
@@ -0,0 +1,88 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <string.h>
+#include <Concurrency/ThreadLocal.h>
+#include <Logging/TimestampCache.h>
+
+using namespace std;
+
+namespace
+{
+
+Threading::ThreadLocal<Threading::TimestampCache>* sTimestampCaches = 0;
+
+class Init
+{
+public:
+
+    Init()
+    {
+        sTimestampCaches = new Threading::ThreadLocal<Threading::TimestampCache>;
+    }
+
+    ~Init()
+    {
+        delete sTimestampCaches;
+        sTimestampCaches = 0;
+    }
+};
+
+Init init;
+}
+
+Threading::TimestampCache::TimestampCache() :
+    m_second(-1),
+    m_length(0)
+{
+    m_prefix[0] = '\0';
+}
+
+void
+Threading::TimestampCache::Append(string& out, const Time& time)
+{
+    Int64 usecs = time.ToMicroSeconds();
+    Int64 second = usecs / 1000000;
+    if (second != m_second)
+    {
+        //
+        // Let ToDateTime() format the whole second, so that both agree on
+        // the layout, and keep it without the milliseconds.
+        //
+        string s = Time::Seconds(second).ToDateTime();
+        m_length = s.size() - 3;
+        if (m_length >= MaxLength)
+        {
+            out += time.ToDateTime();
+            return;
+        }
+        memcpy(m_prefix, s.data(), m_length);
+        m_second = second;
+    }
+
+    long msecs = static_cast<long>(usecs % 1000000 / 1000);
+    char millis[3];
+    millis[0] = static_cast<char>('0' + msecs / 100);
+    millis[1] = static_cast<char>('0' + msecs / 10 % 10);
+    millis[2] = static_cast<char>('0' + msecs % 10);
+
+    out.append(m_prefix, m_length);
+    out.append(millis, sizeof(millis));
+}
+
+void
+Threading::AppendLogTimestamp(string& out)
+{
+    if (0 == sTimestampCaches)
+    {
+        // Called during static initialization or destruction.
+        out += Time::Now().ToDateTime();
+        return;
+    }
+    sTimestampCaches->Pointer()->Append(out, Time::Now());
+}
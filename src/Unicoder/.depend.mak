@@ -1,3 +1,3 @@
 Unicode$(OBJEXT): Unicode.cpp "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Exception.h" "$(includedir)/Unicoder/ConvertUTF.h"
-StringConverter$(OBJEXT): StringConverter.cpp "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Shared.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/ScopedArray.h" "$(includedir)/Unicoder/IconvStringConverter.h" "$(includedir)/Build/UndefSysMacros.h"
+StringConverter$(OBJEXT): StringConverter.cpp "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/ScopedArray.h" "$(includedir)/Unicoder/IconvStringConverter.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h"
 ConvertUTF$(OBJEXT): ConvertUTF.cpp "$(includedir)/Unicoder/ConvertUTF.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Exception.h"
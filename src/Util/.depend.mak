@@ -1,8 +1,9 @@
-Atomic$(OBJEXT): Atomic.cpp "$(includedir)/Util/Atomic.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h"
-Shared$(OBJEXT): Shared.cpp "$(includedir)/Util/Shared.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h"
-FileUtil$(OBJEXT): FileUtil.cpp "$(includedir)/Util/DisableWarnings.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Shared.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h"
+Atomic$(OBJEXT): Atomic.cpp "$(includedir)/Util/Atomic.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h"
+Shared$(OBJEXT): Shared.cpp "$(includedir)/Util/Shared.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Atomic.h"
+FileUtil$(OBJEXT): FileUtil.cpp "$(includedir)/Util/DisableWarnings.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h"
 Exception$(OBJEXT): Exception.cpp "$(includedir)/Util/Exception.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/MutexPtrLock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h"
 Time$(OBJEXT): Time.cpp "$(includedir)/Util/Time.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Exception.h"
-Properties$(OBJEXT): Properties.cpp "$(includedir)/Util/Properties.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/DisableWarnings.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Logging/LoggerUtil.h"
-StringUtil$(OBJEXT): StringUtil.cpp "$(includedir)/Util/StringUtil.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Shared.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Util/ScopedArray.h"
+Properties$(OBJEXT): Properties.cpp "$(includedir)/Util/Properties.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Time.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/DisableWarnings.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Logging/LoggerUtil.h"
+StringUtil$(OBJEXT): StringUtil.cpp "$(includedir)/Util/StringUtil.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Util/Exception.h" "$(includedir)/Util/Shared.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Build/UndefSysMacros.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/ScopedArray.h"
 ErrorToString$(OBJEXT): ErrorToString.cpp "$(includedir)/Util/ErrorToString.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Util/Exception.h"
+BiasedShared$(OBJEXT): BiasedShared.cpp "$(includedir)/Util/Shared.h" "$(includedir)/Config.h" "$(includedir)/Build/BuildConfig.h" "$(includedir)/Build/NonCopyable.h" "$(includedir)/Build/UsefulMacros.h" "$(includedir)/Util/Port.h" "$(includedir)/Util/Atomic.h" "$(includedir)/Util/BiasedShared.h" "$(includedir)/Util/SharedPtr.h" "$(includedir)/Util/Exception.h" "$(includedir)/Concurrency/Mutex.h" "$(includedir)/Concurrency/Lock.h" "$(includedir)/Concurrency/ThreadException.h" "$(includedir)/Util/Time.h" "$(includedir)/Concurrency/ThreadLocal.h" "$(includedir)/Util/TypeTraits.h" "$(includedir)/Logging/Logger.h" "$(includedir)/Logging/ColorStream.h" "$(includedir)/Util/StringUtil.h" "$(includedir)/Util/ErrorToString.h" "$(includedir)/Util/FileUtil.h" "$(includedir)/Unicoder/StringConverter.h" "$(includedir)/Unicoder/Unicode.h" "$(includedir)/Logging/LogSink.h" "$(includedir)/Concurrency/MutexPtrLock.h" "$(includedir)/Concurrency/Thread.h" "$(includedir)/Concurrency/ThreadControl.h" "$(includedir)/Concurrency/CpuSet.h" "$(includedir)/Build/UndefSysMacros.h"
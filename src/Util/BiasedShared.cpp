@@ -0,0 +1,634 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+#include <algorithm>
+#include <vector>
+#include <Util/Shared.h>
+#include <Util/BiasedShared.h>
+#include <Concurrency/Mutex.h>
+#include <Concurrency/MutexPtrLock.h>
+#include <Concurrency/ThreadLocal.h>
+#include <Concurrency/Thread.h>
+
+THREADING_BEGIN
+
+namespace internal
+{
+
+//
+// The record of a thread. The owner side of the objects biased to it:
+// the objects handed back by the other threads, merged by the owner or,
+// once it exited, by whoever hands them back. And the counts it caches
+// for the objects biased to the other threads.
+//
+class BiasedOwner : public Shared
+{
+public:
+
+    enum
+    {
+        CacheSize = 64
+    };
+
+    BiasedOwner() :
+        m_exited(0),
+        m_pending(0),
+        m_cachebusy(0)
+    {
+        for (int i = 0; i < CacheSize; ++i)
+        {
+            m_cache[i].m_object = 0;
+            m_cache[i].m_count = 0;
+        }
+    }
+
+    //
+    // Adds count to the references the calling thread, which this record
+    // is of, holds to object.
+    //
+    void Defer(BiasedShared* object, int count)
+    {
+        Cached& cached = m_cache[slot(object)];
+        BiasedShared* evicted = 0;
+        BiasedShared::Outcome evictedOutcome = BiasedShared::Alive;
+        BiasedShared::Outcome outcome = BiasedShared::Alive;
+        {
+            CacheLock sync(m_cachebusy);
+            if (cached.m_object != object && cached.m_object)
+            {
+                evicted = cached.m_object;
+                evictedOutcome = evicted->addShared(cached.m_count);
+                cached.m_object = 0;
+            }
+
+            if (object->cacheable())
+            {
+                if (!cached.m_object)
+                {
+                    cached.m_object = object;
+                    cached.m_count = 0;
+                }
+                cached.m_count += count;
+            }
+            else
+            {
+                //
+                // Merged since the thread cached it, if it was not
+                // collected yet.
+                //
+                if (cached.m_object)
+                {
+                    count += cached.m_count;
+                    cached.m_object = 0;
+                }
+                outcome = object->addShared(count);
+            }
+        }
+
+        if (evicted)
+        {
+            evicted->settle(evictedOutcome);
+        }
+        object->settle(outcome);
+    }
+
+    // Adds all the counts cached to the shared counts.
+    void Flush()
+    {
+        std::vector<std::pair<BiasedShared*, BiasedShared::Outcome> > flushed;
+        {
+            CacheLock sync(m_cachebusy);
+            for (int i = 0; i < CacheSize; ++i)
+            {
+                if (m_cache[i].m_object)
+                {
+                    flushed.push_back(std::make_pair(m_cache[i].m_object, m_cache[i].m_object->addShared(m_cache[i].m_count)));
+                    m_cache[i].m_object = 0;
+                }
+            }
+        }
+
+        for (std::vector<std::pair<BiasedShared*, BiasedShared::Outcome> >::const_iterator iter = flushed.begin();
+             iter != flushed.end(); ++iter)
+        {
+            iter->first->settle(iter->second);
+        }
+    }
+
+    //
+    // Whether the thread exited: the objects biased to it are merged as
+    // soon as they are handed back, their counts are not worth caching.
+    //
+    bool Exited() const
+    {
+        return 0 != AtomicLoad(&m_exited, MemoryOrderRelaxed);
+    }
+
+    // Removes the count cached for object, returns it.
+    int Collect(BiasedShared* object)
+    {
+        Cached& cached = m_cache[slot(object)];
+        CacheLock sync(m_cachebusy);
+        if (cached.m_object != object)
+        {
+            return 0;
+        }
+        cached.m_object = 0;
+        return cached.m_count;
+    }
+
+    void Enqueue(BiasedShared* object)
+    {
+        {
+            Threading::Mutex::LockGuard sync(m_mutex);
+            if (!m_exited)
+            {
+                m_queue.push_back(object);
+                AtomicStore(&m_pending, 1, MemoryOrderRelaxed);
+                return;
+            }
+        }
+        object->mergeQueued();
+    }
+
+    void Drain()
+    {
+        if (0 == AtomicLoad(&m_pending, MemoryOrderRelaxed))
+        {
+            return;
+        }
+
+        std::vector<BiasedShared*> queue;
+        {
+            Threading::Mutex::LockGuard sync(m_mutex);
+            queue.swap(m_queue);
+            AtomicStore(&m_pending, 0, MemoryOrderRelaxed);
+        }
+        merge(queue);
+    }
+
+    void Exit()
+    {
+        std::vector<BiasedShared*> queue;
+        {
+            Threading::Mutex::LockGuard sync(m_mutex);
+            AtomicStore(&m_exited, 1, MemoryOrderRelaxed);
+            queue.swap(m_queue);
+        }
+        merge(queue);
+    }
+
+private:
+
+    //
+    // Guards the cache: taken by its thread on every copy and release, by
+    // the collecting threads seldom, and never held across a call that
+    // may block.
+    //
+    class CacheLock
+    {
+    public:
+
+        explicit CacheLock(volatile int& busy) :
+            m_busy(busy)
+        {
+            while (0 != AtomicExchange(&m_busy, 1, MemoryOrderAcquire))
+            {
+                ThreadControl::Yield();
+            }
+        }
+
+        ~CacheLock()
+        {
+            AtomicStore(&m_busy, 0, MemoryOrderRelease);
+        }
+
+    private:
+
+        volatile int& m_busy;
+    };
+
+    struct Cached
+    {
+        BiasedShared* m_object;     // 0 if the entry is free.
+        int m_count;
+    };
+
+    static int slot(const BiasedShared* object)
+    {
+        return static_cast<int>((reinterpret_cast<size_t>(object) >> 4) & (CacheSize - 1));
+    }
+
+    static void merge(const std::vector<BiasedShared*>& queue)
+    {
+        for (std::vector<BiasedShared*>::const_iterator iter = queue.begin(); iter != queue.end(); ++iter)
+        {
+            (*iter)->mergeQueued();
+        }
+    }
+
+    Threading::Mutex m_mutex;
+    volatile int m_exited;
+    std::vector<BiasedShared*> m_queue;
+    volatile int m_pending;     // m_queue is not empty.
+
+    //
+    // Only contended by the threads collecting the counts of an object:
+    // no other thread writes to the cache lines of the thread's copies.
+    //
+    volatile int m_cachebusy;
+    Cached m_cache[CacheSize];
+};
+
+}
+
+THREADING_END
+
+namespace
+{
+
+Threading::Mutex* sRecordsMutex = 0;
+std::vector<Threading::internal::BiasedOwner*>* sRecords = 0;  // The records of the live threads.
+
+//
+// The record of a thread, which exits along with the thread: from the
+// Thread exit hook, or the ThreadLocal destructor, whichever runs first.
+//
+class BiasedOwnerHandle
+{
+public:
+
+    BiasedOwnerHandle() :
+        m_exited(false)
+    {
+    }
+
+    // Only the empty default value is ever copied.
+    BiasedOwnerHandle(const BiasedOwnerHandle&) :
+        m_exited(false)
+    {
+    }
+
+    ~BiasedOwnerHandle()
+    {
+        Exit();
+    }
+
+    void Exit()
+    {
+        if (m_owner && !m_exited)
+        {
+            m_exited = true;
+#ifdef UTIL_BIASED_OWNER_TLS
+            Threading::internal::tCurrentBiasedOwner = 0;
+#endif
+            m_owner->Flush();
+            {
+                Threading::MutexPtrLock<Threading::Mutex> lock(sRecordsMutex);
+                if (0 != sRecords)
+                {
+                    sRecords->erase(std::remove(sRecords->begin(), sRecords->end(), m_owner.Get()), sRecords->end());
+                }
+            }
+            m_owner->Exit();
+        }
+    }
+
+    Threading::internal::BiasedOwnerPtr m_owner;
+    bool m_exited;              // The objects created from now on have no owner.
+
+private:
+
+    BiasedOwnerHandle& operator =(const BiasedOwnerHandle&);
+};
+
+Threading::ThreadLocal<BiasedOwnerHandle>* sOwners = 0;
+
+void
+exitThread()
+{
+    BiasedOwnerHandle* handle = 0 == sOwners ? 0 : sOwners->Find();
+    if (handle)
+    {
+        handle->Exit();
+    }
+}
+
+class Init
+{
+public:
+
+    Init()
+    {
+        sRecordsMutex = new Threading::Mutex;
+        sRecords = new std::vector<Threading::internal::BiasedOwner*>;
+        sOwners = new Threading::ThreadLocal<BiasedOwnerHandle>;
+        Threading::internal::AddThreadExitHook(&exitThread);
+    }
+
+    ~Init()
+    {
+        //
+        // Exits the owner of this thread; the objects it merges must not
+        // find the records half destroyed.
+        //
+        Threading::ThreadLocal<BiasedOwnerHandle>* owners = sOwners;
+        sOwners = 0;
+        delete owners;
+
+        delete sRecords;
+        sRecords = 0;
+        delete sRecordsMutex;
+        sRecordsMutex = 0;
+    }
+};
+
+Init init;
+
+Threading::internal::BiasedOwnerPtr
+createOwner()
+{
+    if (0 == sOwners)
+    {
+        return 0;
+    }
+
+    BiasedOwnerHandle* handle = sOwners->Pointer();
+    if (!handle->m_owner && !handle->m_exited)
+    {
+        handle->m_owner = new Threading::internal::BiasedOwner();
+        {
+            Threading::MutexPtrLock<Threading::Mutex> lock(sRecordsMutex);
+            if (0 != sRecords)
+            {
+                sRecords->push_back(handle->m_owner.Get());
+            }
+        }
+#ifdef UTIL_BIASED_OWNER_TLS
+        Threading::internal::tCurrentBiasedOwner = handle->m_owner.Get();
+#endif
+    }
+    return handle->m_exited ? Threading::internal::BiasedOwnerPtr() : handle->m_owner;
+}
+
+// Removes the counts the threads cache for object, returns their sum.
+int
+collect(Threading::BiasedShared* object)
+{
+    int count = 0;
+    Threading::MutexPtrLock<Threading::Mutex> lock(sRecordsMutex);
+    if (0 != sRecords)
+    {
+        for (std::vector<Threading::internal::BiasedOwner*>::const_iterator iter = sRecords->begin();
+             iter != sRecords->end(); ++iter)
+        {
+            count += (*iter)->Collect(object);
+        }
+    }
+    return count;
+}
+
+}
+
+#ifdef UTIL_BIASED_OWNER_TLS
+__thread Threading::internal::BiasedOwner* Threading::internal::tCurrentBiasedOwner = 0;
+#else
+Threading::internal::BiasedOwner*
+Threading::internal::CurrentBiasedOwner()
+{
+    BiasedOwnerHandle* handle = 0 == sOwners ? 0 : sOwners->Pointer();
+    return 0 == handle || handle->m_exited ? 0 : handle->m_owner.Get();
+}
+#endif
+
+Threading::BiasedShared::BiasedShared() :
+    m_owner(createOwner()),
+    m_biased(0),
+    m_merged(!m_owner),
+    m_shared(m_owner ? 0 : static_cast<int>(MergedFlag)),
+    m_noDelete(false)
+{
+}
+
+Threading::BiasedShared::BiasedShared(const BiasedShared&) :
+    m_owner(createOwner()),
+    m_biased(0),
+    m_merged(!m_owner),
+    m_shared(m_owner ? 0 : static_cast<int>(MergedFlag)),
+    m_noDelete(false)
+{
+}
+
+Threading::BiasedShared::~BiasedShared()
+{
+}
+
+int
+Threading::BiasedShared::GetRef() const
+{
+    int shared = AtomicLoad(&m_shared, MemoryOrderAcquire);
+    return countOf(shared) + (isOwner() ? m_biased : 0);
+}
+
+void
+Threading::BiasedShared::MergeQueued()
+{
+    internal::BiasedOwner* owner = internal::CurrentBiasedOwner();
+    if (owner)
+    {
+        owner->Flush();
+        owner->Drain();
+    }
+}
+
+//
+// A thread other than the owner copies (count 1) or releases (count -1)
+// a reference.
+//
+void
+Threading::BiasedShared::defer(int count)
+{
+    internal::BiasedOwner* owner = internal::CurrentBiasedOwner();
+    if (!owner)
+    {
+        owner = createOwner().Get();
+    }
+
+    if (owner)
+    {
+        owner->Defer(this, count);
+    }
+    else
+    {
+        settle(addShared(count));
+    }
+}
+
+//
+// Whether the calling thread may cache its count, called with its cache
+// locked: until the object is merged, whoever merges it collects the
+// counts of the threads marked CachedFlag.
+//
+bool
+Threading::BiasedShared::cacheable()
+{
+    int shared = AtomicLoad(&m_shared, MemoryOrderAcquire);
+    for (;;)
+    {
+        if (0 != (shared & MergedFlag) || m_owner->Exited())
+        {
+            return false;
+        }
+
+        if (0 != (shared & CachedFlag) ||
+            AtomicCompareExchange(&m_shared, shared, shared | CachedFlag, MemoryOrderAcqRel))
+        {
+            return true;
+        }
+    }
+}
+
+Threading::BiasedShared::Outcome
+Threading::BiasedShared::addShared(int count)
+{
+    if (count >= 0)
+    {
+        AtomicFetchAdd(&m_shared, count * CountOne, MemoryOrderRelaxed);
+        return Alive;
+    }
+
+    int shared = AtomicLoad(&m_shared, MemoryOrderRelaxed);
+    for (;;)
+    {
+        //
+        // Before the merge, a shared count down to zero or below may be
+        // the last reference, but only the owner knows its own count.
+        //
+        int next = shared + count * CountOne;
+        bool handback = 0 == (shared & (QueuedFlag | MergedFlag)) && countOf(next) <= 0;
+        if (handback)
+        {
+            next |= QueuedFlag;
+        }
+
+        if (AtomicCompareExchange(&m_shared, shared, next, MemoryOrderAcqRel))
+        {
+            if (handback)
+            {
+                return HandBack;
+            }
+            return MergedFlag == (next & (QueuedFlag | MergedFlag)) && 0 == countOf(next) ? Dead : Alive;
+        }
+    }
+}
+
+// Called once the thread that added to the shared count released its cache.
+void
+Threading::BiasedShared::settle(Outcome outcome)
+{
+    if (HandBack == outcome)
+    {
+        m_owner->Enqueue(this);
+    }
+    else if (Dead == outcome)
+    {
+        destroy();
+    }
+}
+
+//
+// The owner dropped its last reference: from now on the shared count is
+// the only one. The counts the threads cached are collected first, under
+// QueuedFlag so that nobody deletes the object meanwhile, unless it was
+// handed back and mergeQueued() does it.
+//
+void
+Threading::BiasedShared::merge()
+{
+    m_merged = true;
+    int shared = AtomicLoad(&m_shared, MemoryOrderRelaxed);
+    int next;
+    do
+    {
+        next = shared + MergedFlag;
+        if (CachedFlag == (shared & (CachedFlag | QueuedFlag)))
+        {
+            next |= QueuedFlag;
+        }
+    }
+    while (!AtomicCompareExchange(&m_shared, shared, next, MemoryOrderAcqRel));
+
+    if (0 != (next & QueuedFlag))
+    {
+        if (0 == (shared & QueuedFlag))
+        {
+            unqueue(next);
+        }
+    }
+    else if (0 == countOf(next))
+    {
+        destroy();
+    }
+}
+
+//
+// Called by the owner for an object handed back to it, or by any thread
+// once the owner exited and nobody updates m_biased any more. The counts
+// are merged for good: the owner count may still hold the references the
+// other threads released, which only the shared count can balance.
+//
+void
+Threading::BiasedShared::mergeQueued()
+{
+    int shared;
+    if (!m_merged)
+    {
+        m_merged = true;
+        int add = m_biased * CountOne + MergedFlag;
+        m_biased = 0;
+        shared = AtomicFetchAdd(&m_shared, add, MemoryOrderAcqRel) + add;
+    }
+    else
+    {
+        shared = AtomicLoad(&m_shared, MemoryOrderAcquire);
+    }
+    unqueue(shared);
+}
+
+//
+// Adds the counts the threads cached, now that none caches any more, and
+// clears QueuedFlag.
+//
+void
+Threading::BiasedShared::unqueue(int shared)
+{
+    int add = -static_cast<int>(QueuedFlag);
+    if (0 != (shared & CachedFlag))
+    {
+        add += collect(this) * CountOne;
+    }
+
+    //
+    // A count of zero is final: no reference is left to copy.
+    //
+    shared = AtomicFetchAdd(&m_shared, add, MemoryOrderAcqRel) + add;
+    if (0 == countOf(shared))
+    {
+        destroy();
+    }
+}
+
+void
+Threading::BiasedShared::destroy()
+{
+    if (!m_noDelete)
+    {
+        m_noDelete = true;
+        delete this;
+    }
+}
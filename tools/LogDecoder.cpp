@@ -0,0 +1,78 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+//
+// Renders binary logs (see Logging/BinaryLog.h) as text.
+//
+//   LogDecoder [file ...]
+//
+// Reads the standard input without file.
+//
+
+#include <iostream>
+#include <Util/FileUtil.h>
+#include <Logging/BinaryLog.h>
+
+using namespace std;
+using namespace Threading;
+
+namespace
+{
+
+const char* const LevelNames[] = { "[  INFO ]", "[WARNING]", "[ ERROR ]", "[ FATAL ]" };
+
+bool
+decode(istream& in, const string& name)
+{
+    BinaryLogReader reader(in);
+    BinaryLogEntry entry;
+    try
+    {
+        while (reader.Next(entry))
+        {
+            cout << LevelNames[entry.m_level] << " " << entry.m_time.ToDateTime() << " "
+                 << FormatFileLocation(entry.m_file.c_str(), entry.m_line) << ": " << entry.m_text << '\n';
+        }
+    }
+    catch (const IllegalArgumentException& ex)
+    {
+        cout.flush();
+        cerr << name << ": " << ex.Reason() << endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return decode(cin, "<stdin>") ? 0 : 1;
+    }
+
+    int status = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        Threading::ifstream in(string(argv[i]), ios_base::in | ios_base::binary);
+        if (!in.is_open())
+        {
+            cerr << argv[i] << ": cannot open" << endl;
+            status = 1;
+            continue;
+        }
+
+        if (!decode(in, argv[i]))
+        {
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,160 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+//
+// Producer/consumer throughput of ThreadSafeQueue, MonitorQueuePolicy
+// against TwoLockQueuePolicy, from 1 to 64 threads.
+//
+//   QueueBench [items per producer]
+//
+// With n threads, n / 2 producers push into one queue and n / 2 consumers
+// pop from it; a single thread pushes and pops in turn.
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+#include <Util/Shared.h>
+#include <Util/Time.h>
+#include <Concurrency/Thread.h>
+#include <Concurrency/CountdownLatch.h>
+#include <Concurrency/ThreadSafeQueue.h>
+
+using namespace std;
+using namespace Threading;
+
+namespace
+{
+
+struct Item : public Shared
+{
+    explicit Item(int value) : m_value(value)
+    {
+    }
+
+    int m_value;
+};
+
+template<typename Queue>
+class Producer : public Thread
+{
+public:
+
+    Producer(Queue& queue, const CountdownLatch& start, int items) :
+        m_queue(queue),
+        m_start(start),
+        m_items(items)
+    {
+    }
+
+    virtual void Run()
+    {
+        m_start.Await();
+        for (int i = 0; i < m_items; ++i)
+        {
+            m_queue.Push(SharedPtr<Item>(new Item(i)));
+        }
+    }
+
+private:
+
+    Queue& m_queue;
+    const CountdownLatch& m_start;
+    const int m_items;
+};
+
+template<typename Queue>
+class Consumer : public Thread
+{
+public:
+
+    Consumer(Queue& queue, const CountdownLatch& start, int items) :
+        m_queue(queue),
+        m_start(start),
+        m_items(items)
+    {
+    }
+
+    virtual void Run()
+    {
+        m_start.Await();
+        for (int i = 0; i < m_items; ++i)
+        {
+            m_queue.Pop();
+        }
+    }
+
+private:
+
+    Queue& m_queue;
+    const CountdownLatch& m_start;
+    const int m_items;
+};
+
+// Returns the operations (a push or a pop) per second.
+template<typename Queue>
+double
+run(int threads, int items)
+{
+    Queue queue;
+    Time begin;
+
+    if (1 == threads)
+    {
+        begin = Time::Now(Time::Monotonic);
+        for (int i = 0; i < items; ++i)
+        {
+            queue.Push(SharedPtr<Item>(new Item(i)));
+            queue.TryPop();
+        }
+        return 2.0 * items / (Time::Now(Time::Monotonic) - begin).ToSecondsDouble();
+    }
+
+    int pairs = threads / 2;
+    CountdownLatch start(1);
+    vector<ThreadPtr> started;
+    for (int i = 0; i < pairs; ++i)
+    {
+        ThreadPtr producer = new Producer<Queue>(queue, start, items);
+        ThreadPtr consumer = new Consumer<Queue>(queue, start, items);
+        producer->Start();
+        consumer->Start();
+        started.push_back(producer);
+        started.push_back(consumer);
+    }
+
+    begin = Time::Now(Time::Monotonic);
+    start.CountDown();
+    for (vector<ThreadPtr>::iterator iter = started.begin(); iter != started.end(); ++iter)
+    {
+        (*iter)->GetThreadControl().Join();
+    }
+    return 2.0 * pairs * items / (Time::Now(Time::Monotonic) - begin).ToSecondsDouble();
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    int items = argc > 1 ? atoi(argv[1]) : 100000;
+    if (items <= 0)
+    {
+        fprintf(stderr, "usage: %s [items per producer]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%8s %16s %16s\n", "threads", "Monitor op/s", "TwoLock op/s");
+    for (int threads = 1; threads <= 64; threads *= 2)
+    {
+        double monitor = run<ThreadSafeQueue<Item, MonitorQueuePolicy> >(threads, items);
+        double twoLock = run<ThreadSafeQueue<Item, TwoLockQueuePolicy> >(threads, items);
+        printf("%8d %16.0f %16.0f\n", threads, monitor, twoLock);
+    }
+    return 0;
+}
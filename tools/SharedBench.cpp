@@ -0,0 +1,142 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+//
+// SharedPtr copy throughput of Shared against BiasedShared, from 1 to 64
+// threads.
+//
+//   SharedBench [copies per thread]
+//
+// "own": every thread copies objects it created, the case BiasedShared
+// is biased to. "one": all the threads copy the same objects, created by
+// the main thread, the copies of BiasedShared being cached per thread;
+// that only pays off once the count of Shared bounces between cores.
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+#include <Util/Shared.h>
+#include <Util/BiasedShared.h>
+#include <Util/Time.h>
+#include <Concurrency/Thread.h>
+#include <Concurrency/CountdownLatch.h>
+
+using namespace std;
+using namespace Threading;
+
+namespace
+{
+
+struct SharedItem : public Shared
+{
+};
+
+struct BiasedItem : public BiasedShared
+{
+};
+
+const int Slots = 16;
+
+template<typename T>
+class Copier : public Thread
+{
+public:
+
+    //
+    // Copies first and second, or objects of its own if they are null,
+    // into a few slots, switching objects on every pass so that each copy
+    // also releases the other object.
+    //
+    Copier(const SharedPtr<T>& first, const SharedPtr<T>& second, const CountdownLatch& start, int copies) :
+        m_first(first),
+        m_second(second),
+        m_start(start),
+        m_copies(copies)
+    {
+    }
+
+    virtual void Run()
+    {
+        SharedPtr<T> items[2] = { m_first, m_second };
+        if (!items[0])
+        {
+            items[0] = new T();
+            items[1] = new T();
+        }
+
+        SharedPtr<T> slots[Slots];
+        m_start.Await();
+        for (int i = 0; i < m_copies; ++i)
+        {
+            slots[i % Slots] = items[(i / Slots) & 1];
+        }
+    }
+
+private:
+
+    const SharedPtr<T> m_first;
+    const SharedPtr<T> m_second;
+    const CountdownLatch& m_start;
+    const int m_copies;
+};
+
+// Returns the copies per second.
+template<typename T>
+double
+run(int threads, int copies, bool own)
+{
+    SharedPtr<T> first;
+    SharedPtr<T> second;
+    if (!own)
+    {
+        first = new T();
+        second = new T();
+    }
+
+    CountdownLatch start(1);
+    vector<ThreadPtr> started;
+    for (int i = 0; i < threads; ++i)
+    {
+        ThreadPtr copier = new Copier<T>(first, second, start, copies);
+        copier->Start();
+        started.push_back(copier);
+    }
+
+    Time begin = Time::Now(Time::Monotonic);
+    start.CountDown();
+    for (vector<ThreadPtr>::iterator iter = started.begin(); iter != started.end(); ++iter)
+    {
+        (*iter)->GetThreadControl().Join();
+    }
+    return 1.0 * threads * copies / (Time::Now(Time::Monotonic) - begin).ToSecondsDouble();
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    int copies = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (copies <= 0)
+    {
+        fprintf(stderr, "usage: %s [copies per thread]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%8s %16s %16s %16s %16s\n", "threads", "Shared own/s", "Biased own/s", "Shared one/s", "Biased one/s");
+    for (int threads = 1; threads <= 64; threads *= 2)
+    {
+        double sharedOwn = run<SharedItem>(threads, copies, true);
+        double biasedOwn = run<BiasedItem>(threads, copies, true);
+        double sharedOne = run<SharedItem>(threads, copies, false);
+        double biasedOne = run<BiasedItem>(threads, copies, false);
+        printf("%8d %16.0f %16.0f %16.0f %16.0f\n", threads, sharedOwn, biasedOwn, sharedOne, biasedOne);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// **********************************************************************
+//
+// Copyright (c) 2010-2014 Bernard Luo. All rights reserved.
+//
+// <Email: luo (dot) xiaowei (at) hotmail (dot) com>
+//
+// **********************************************************************
+
+//
+// Schedule/Cancel churn of Timer, the sorted schedule against the timing
+// wheel, with a growing number of pending tasks.
+//
+//   TimerBench [operations]
+//
+// The tasks are scheduled far enough in the future never to expire, then
+// each operation cancels one at random and schedules it again, the way
+// request timeouts are armed and disarmed.
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+#include <Util/Time.h>
+#include <Concurrency/Timer.h>
+
+using namespace std;
+using namespace Threading;
+
+namespace
+{
+
+class IdleTask : public TimerTask
+{
+public:
+
+    virtual void RunTimerTask()
+    {
+    }
+};
+
+// Returns the Schedule and Cancel calls per second.
+double
+run(const TimerPtr& timer, int pending, int operations)
+{
+    vector<TimerTaskPtr> tasks;
+    tasks.reserve(pending);
+    srand(1);
+    for (int i = 0; i < pending; ++i)
+    {
+        tasks.push_back(new IdleTask());
+        timer->Schedule(tasks.back(), Time::MilliSeconds(60000 + rand() % 60000));
+    }
+
+    Time begin = Time::Now(Time::Monotonic);
+    for (int i = 0; i < operations; ++i)
+    {
+        const TimerTaskPtr& task = tasks[rand() % pending];
+        timer->Cancel(task);
+        timer->Schedule(task, Time::MilliSeconds(60000 + rand() % 60000));
+    }
+    double rate = 2.0 * operations / (Time::Now(Time::Monotonic) - begin).ToSecondsDouble();
+
+    timer->Destroy();
+    return rate;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    int operations = argc > 1 ? atoi(argv[1]) : 200000;
+    if (operations <= 0)
+    {
+        fprintf(stderr, "usage: %s [operations]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%8s %16s %16s\n", "pending", "Sorted op/s", "Wheel op/s");
+    for (int pending = 10; pending <= 1000000; pending *= 10)
+    {
+        double sorted = run(new Timer(), pending, operations);
+        double wheel = run(new Timer(Time::MilliSeconds(1)), pending, operations);
+        printf("%8d %16.0f %16.0f\n", pending, sorted, wheel);
+    }
+    return 0;
+}